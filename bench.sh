@@ -0,0 +1,192 @@
+# Runs ga on every instance of input/ that has a known-best cut in input/sol_*.txt
+# and reports throughput, time to 99% / 99.9% / 100% of that cut and the final gap.
+#
+#   make bench [BENCH_TIME=10] [BENCH_SEEDS="1 2 3"] [BENCH_ARGS="-j 4"] [BENCH_INSTANCES="g1 g2"] [BENCH_PERF=1]
+#              [BENCH_ORDERINGS="dfs rcm grid spectral"]
+#
+# Results go to bench/results.csv and bench/results.json, one row per instance and seed with the time budget,
+# and are compared per instance with bench/baseline.csv if it exists, over the seeds both ran.
+# rows of another time budget are not compared, their times and gaps do not mean the same.
+# BENCH_PERF=1 runs ga with -P and writes the hardware counters of every phase to bench/perf.csv,
+# the throughput of those runs is a little lower.
+# BENCH_ORDERINGS runs every instance and seed once per vertex ordering (-O) and ends with a table
+# per instance and ordering, with the cache misses of local_opt if BENCH_PERF is set too.
+# only dfs runs, the default ordering, are compared with the baseline.
+# `make bench-baseline` stores the last results as the new baseline.
+
+TIME=${BENCH_TIME:-10}
+SEEDS=${BENCH_SEEDS:-1 2 3}
+ARGS=${BENCH_ARGS:-}
+BASELINE=${BENCH_BASELINE:-bench/baseline.csv}
+CSV=bench/results.csv
+JSON=bench/results.json
+HEADER="instance,seed,V,E,target,final,gap,generations_per_s,children_per_s,local_opts_per_s,t99,t999,t100,ordering,budget"
+PERF_CSV=bench/perf.csv
+PERF_HEADER="instance,seed,phase,cycles,instructions,ipc,branch_mpki,l1d_mpki,llc_mpki,ordering"
+ORDERINGS=${BENCH_ORDERINGS:-dfs}
+if [ -n "$BENCH_PERF" ]; then
+    ARGS="$ARGS -P"
+fi
+
+if [ -z "$BENCH_INSTANCES" ]; then
+    for sol in input/sol_*.txt; do
+        name=$(basename $sol .txt)
+        BENCH_INSTANCES="$BENCH_INSTANCES ${name#sol_}"
+    done
+fi
+
+mkdir -p bench
+echo $HEADER > $CSV
+if [ -n "$BENCH_PERF" ]; then
+    echo $PERF_HEADER > $PERF_CSV
+fi
+for name in $BENCH_INSTANCES; do
+    input=input/$name.txt
+    size=$(head -1 $input | awk '{ print $1 "," $2 }')
+    target=$(./ga -e input/sol_$name.txt < $input)
+    for ordering in $ORDERINGS; do
+    for seed in $SEEDS; do
+        ./ga -t $TIME -s $seed -S -O $ordering $ARGS < $input > bench/$name.out 2> bench/$name.log
+        final=$(./ga -e bench/$name.out < $input)
+        # "best <seconds> <score>" on every improvement, "stats key=value ..." at the end
+        awk -v name=$name -v seed=$seed -v target=$target -v final=$final -v size=$size -v ordering=$ordering -v budget=$TIME '
+            function seconds(t) {
+                return (t == "") ? "" : sprintf("%.3f", t)
+            }
+            $1 == "best" {
+                if (t99 == "" && $3 >= 0.99 * target) t99 = $2
+                if (t999 == "" && $3 >= 0.999 * target) t999 = $2
+                if (t100 == "" && $3 >= target) t100 = $2
+            }
+            $1 == "stats" {
+                for (i = 2; i <= NF; i++) {
+                    split($i, kv, "=")
+                    stat[kv[1]] = kv[2]
+                }
+            }
+            END {
+                loop = stat["loop"] > 0 ? stat["loop"] : 1
+                printf "%s,%s,%s,%d,%d,%.6f,%.2f,%.1f,%.1f,%s,%s,%s,%s,%s\n", name, seed, size, target, final,
+                       (target - final) / target, stat["generations"] / loop, stat["children"] / loop,
+                       stat["local_opts"] / loop, seconds(t99), seconds(t999), seconds(t100), ordering, budget
+            }' bench/$name.log | tee -a $CSV
+        if [ -n "$BENCH_PERF" ]; then
+            # "perf phase=<phase> cycles=.. instructions=.. ..." per phase, misses per 1000 instructions
+            awk -v name=$name -v seed=$seed -v ordering=$ordering '
+                function per(x, n) {
+                    return (x == "n/a" || n == "n/a" || n == 0) ? "" : sprintf("%.3f", x / n)
+                }
+                $1 == "perf" {
+                    for (i = 2; i <= NF; i++) {
+                        split($i, kv, "=")
+                        stat[kv[1]] = kv[2]
+                    }
+                    k = stat["instructions"] / 1000
+                    printf "%s,%s,%s,%s,%s,%s,%s,%s,%s,%s\n", name, seed, stat["phase"], stat["cycles"],
+                           stat["instructions"], per(stat["instructions"], stat["cycles"]),
+                           per(stat["branch_misses"], k), per(stat["l1d_misses"], k), per(stat["llc_misses"], k),
+                           ordering
+                }' bench/$name.log >> $PERF_CSV
+        fi
+    done
+    done
+done
+
+# the same rows as a JSON array, unreached targets become null
+awk -F, '
+    NR == 1 { for (i = 1; i <= NF; i++) key[i] = $i; print "["; next }
+    {
+        printf "%s  {", (NR > 2 ? ",\n" : "")
+        for (i = 1; i <= NF; i++) {
+            value = (i == 1 || key[i] == "ordering") ? "\"" $i "\"" : ($i == "" ? "null" : $i)
+            printf "%s\"%s\": %s", (i > 1 ? ", " : ""), key[i], value
+        }
+        printf "}"
+    }
+    END { print "\n]" }' $CSV > $JSON
+
+# per instance means against the baseline over the seeds in both: throughput ratio, mean time to 99%
+# and final gap. runs that never reached 99% count as their whole time budget
+if [ -f $BASELINE ]; then
+    echo ""
+    echo "compared with $BASELINE"
+    awk -F, -v csv=$CSV -v time=$TIME '
+        FNR == 1 { file = FILENAME == csv ? 2 : 1; next }
+        $14 != "" && $14 != "dfs" { next }
+        {
+            key = $1 SUBSEP $2
+            if (file == 2) keys[++count] = key
+            budget[file, key] = $15
+            children[file, key] = $9
+            t99[file, key] = ($11 == "") ? $15 : $11
+            gap[file, key] = $7
+        }
+        END {
+            printf "%-26s %24s %20s %22s\n", "instance", "children/s", "t99 (s)", "gap"
+            for (i = 1; i <= count; i++) {
+                key = keys[i]
+                split(key, part, SUBSEP)
+                name = part[1]
+                if (!((1, key) in budget)) continue
+                if (budget[1, key] == "" || budget[1, key] != budget[2, key]) {
+                    skipped[name] = budget[1, key] == "" ? "?" : budget[1, key]
+                    continue
+                }
+                if (!(name in n)) names[++num_names] = name
+                n[name]++
+                for (f = 1; f <= 2; f++) {
+                    sum_children[f, name] += children[f, key]
+                    sum_t99[f, name] += t99[f, key]
+                    sum_gap[f, name] += gap[f, key]
+                }
+            }
+            for (i = 1; i <= num_names; i++) {
+                name = names[i]
+                b = sum_children[1, name] / n[name]
+                c = sum_children[2, name] / n[name]
+                printf "%-26s %9.0f -> %9.0f x%.2f %8.2f -> %8.2f %10.6f -> %9.6f  (%d seeds)\n", name, b, c, c / b,
+                       sum_t99[1, name] / n[name], sum_t99[2, name] / n[name],
+                       sum_gap[1, name] / n[name], sum_gap[2, name] / n[name], n[name]
+            }
+            for (name in skipped)
+                if (!(name in n))
+                    printf "%-26s not compared, the baseline ran %s s a seed, these results %s s\n", name,
+                           skipped[name], time
+        }' $BASELINE $CSV
+fi
+
+# per instance and ordering: throughput, mean time to 99%, final gap and the misses of local_opt
+if [ "$ORDERINGS" != "dfs" ]; then
+    echo ""
+    echo "orderings"
+    # /dev/null has no header line to count, so the files are told apart by name
+    awk -F, -v budget=$TIME -v csv=$CSV '
+        FNR == 1 { file = FILENAME == csv ? 2 : 1; next }
+        file == 1 && $3 == "local_opt" && $8 != "" {
+            key = $1 SUBSEP $10
+            runs[key]++
+            l1d[key] += $8
+            llc[key] += $9
+            next
+        }
+        file == 2 {
+            key = $1 SUBSEP $14
+            if (!(key in n)) keys[++count] = key
+            n[key]++
+            children[key] += $9
+            t99[key] += ($11 == "") ? budget : $11
+            gap[key] += $7
+        }
+        END {
+            printf "%-26s %-9s %10s %8s %10s %9s %9s\n", "instance", "ordering", "children/s", "t99 (s)", "gap",
+                   "l1d_mpki", "llc_mpki"
+            for (i = 1; i <= count; i++) {
+                key = keys[i]
+                split(key, part, SUBSEP)
+                printf "%-26s %-9s %10.0f %8.2f %10.6f %9s %9s\n", part[1], part[2], children[key] / n[key],
+                       t99[key] / n[key], gap[key] / n[key],
+                       runs[key] ? sprintf("%.3f", l1d[key] / runs[key]) : "-",
+                       runs[key] ? sprintf("%.3f", llc[key] / runs[key]) : "-"
+            }
+        }' $( [ -f $PERF_CSV ] && [ -n "$BENCH_PERF" ] && echo $PERF_CSV || echo /dev/null ) $CSV
+fi
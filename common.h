@@ -0,0 +1,139 @@
+// what ga.cpp, multi_start.cpp and the server tools share. it has internal linkage like all of ga.cpp
+// but main() and the maxcut:: API, so libmaxcut.a exports none of it
+#ifndef COMMON_H
+#define COMMON_H
+
+#include <cstdlib>
+#include <ctime>
+#include <cerrno>
+
+#include <vector>
+#include <system_error>
+
+// counters of ga_telemetry, ga.cpp defines PROBE before it includes this
+#ifndef PROBE
+#define PROBE(...)
+#endif
+
+namespace {
+
+inline double get_time() {
+	struct timespec ts;
+	// seconds on a clock that is never set back, only differences are used
+	if (clock_gettime(CLOCK_MONOTONIC, &ts)) {
+#ifdef MAXCUT_LIBRARY
+		throw std::system_error(errno, std::generic_category(), "clock_gettime");  // fails the solve only
+#else
+		exit(errno);
+#endif
+	}
+	return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// vertices with positive gain in an indexed binary max-heap,
+// pos[] lets a changed gain be moved in place instead of pushed again
+class gain_heap {
+public:
+	const int *keys;
+	std::vector<int> heap, pos;  // pos[v] = -1 if v is not in the heap
+	PROBE(long long updates = 0, noops = 0;)  // noops left the heap as it was
+
+	// vertices 0 .. n - 1
+	void init(int n) {
+		heap.reserve(n);
+		pos.assign(n, -1);
+	}
+
+	// heap is empty here, local_opt() always pops until nothing is left
+	void reset(const int *keys_) {
+		keys = keys_;
+		for (int v = 0; v < (int)pos.size(); v++)
+			if (keys[v] > 0) {
+				pos[v] = heap.size();
+				heap.push_back(v);
+			}
+		for (int i = (int)heap.size() / 2 - 1; i >= 0; i--)
+			sift_down(i);
+	}
+
+	void update(int v) {
+		PROBE(updates++);
+		if (pos[v] < 0) {
+			if (keys[v] <= 0) {
+				PROBE(noops++);
+				return;
+			}
+			pos[v] = heap.size();
+			heap.push_back(v);
+			sift_up(pos[v]);
+		} else if (keys[v] <= 0) {
+			erase(v);
+		} else {
+			sift_up(pos[v]);
+			sift_down(pos[v]);
+		}
+	}
+
+	// empty the heap for the next reset()
+	void clear() {
+		for (int v : heap)
+			pos[v] = -1;
+		heap.clear();
+	}
+
+	// the vertex pop() would return, left in the heap
+	int peek() const {
+		return heap.empty() ? -1 : heap[0];
+	}
+
+	// vertex with the largest gain, -1 if no gain is positive
+	int pop() {
+		if (heap.empty()) return -1;
+		int v = heap[0];
+		erase(v);
+		return v;
+	}
+
+	void erase(int v) {
+		int i = pos[v], last = heap.back();
+		heap.pop_back();
+		pos[v] = -1;
+		if (last == v) return;
+		heap[i] = last;
+		pos[last] = i;
+		sift_up(i);
+		sift_down(pos[last]);
+	}
+
+	void sift_up(int i) {
+		int v = heap[i];
+		while (i > 0) {
+			int parent = (i - 1) / 2;
+			if (keys[heap[parent]] >= keys[v]) break;
+			heap[i] = heap[parent];
+			pos[heap[i]] = i;
+			i = parent;
+		}
+		heap[i] = v;
+		pos[v] = i;
+	}
+
+	void sift_down(int i) {
+		int v = heap[i], n = heap.size();
+		while (2 * i + 1 < n) {
+			int child = 2 * i + 1;
+			if (child + 1 < n && keys[heap[child + 1]] > keys[heap[child]])
+				child++;
+			if (keys[heap[child]] <= keys[v]) break;
+			heap[i] = heap[child];
+			pos[heap[i]] = i;
+			i = child;
+		}
+		heap[i] = v;
+		pos[v] = i;
+	}
+};
+
+}  // namespace
+
+#endif
@@ -3,321 +3,2653 @@
 #include <ctime>
 #include <cerrno>
 #include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#include <immintrin.h>
 
 #include <vector>
 #include <queue>
 #include <tuple>
 #include <algorithm>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <new>
+#include <stdexcept>
+
+#include "maxcut.h"
 
-#define MAX_V 5000
-#define MAX_E 40000
-#define MOD 1000000007
 #define SPARE_TIME 1
 
 #define MAX_POPULATION 32768
 #define NUM_CHILDREN 1024
 #define CUTTING_POINT 2
 // #define NUM_LOCAL_OPT 10
+#define NUM_THREADS 0  // 0: one thread per hardware thread, overridden by -j
+#define CHILDREN_CHUNK 8  // children claimed by a worker at once
+#define MAX_BUCKETS 65536  // gain_buckets is used if no gain can exceed this
+#define GAIN_CACHE_MB 1024  // chromosomes keep their flip gains if they fit, overridden by -g
+#define POPULATION_MB 2048  // fewer than MAX_POPULATION individuals if chromosomes exceed this, -m
+#define POOL_CHUNK (2 << 20)  // bytes mapped at once by chromosome_pool, one huge page
+#define POOL_BATCH 64  // slots moved between a thread cache and the shared free list
+#define MIGRATION_INTERVAL 50  // generations between migrations of the island model, -K
+#define NUM_MIGRANTS 4  // best individuals an island sends, -M
+#define DELIVERED_HASHES 1024  // migrants the coordinator remembers per worker, so it does not send them twice
+#define TABU_ITERATIONS 1000  // moves of tabu search per child, -n
+#define TABU_TENURE 10  // random part of the tabu tenure, added to V / 150
+#define BINARY_MAGIC "MAXCUTB2"  // first 8 bytes of a renumbered graph written by -b
+#define CHECKPOINT_MAGIC "MAXCUTK1"  // first 8 bytes of a checkpoint written by -c
+#define CHECKPOINT_INTERVAL 60  // seconds between checkpoints, -C
+#define GRID_LANDMARKS 3  // pseudo coordinates of the grid ordering, one per dimension of a torus
+#define SPECTRAL_ITERATIONS 300  // power iterations for the Fiedler vector of the spectral ordering
+#define EXACT_VERTICES 16  // components up to this size are solved by trying every partition
+#define RESTART_ELITE 64  // best members a restart keeps, the rest of the population is random again
+// #define TELEMETRY  // phase timers and counters as JSON lines on stderr, make ga_telemetry
+#define TELEMETRY_INTERVAL 1.0  // seconds between JSON lines
+#define TELEMETRY_BINS 24  // log2 histogram bins, the last one takes everything larger
+#define DIVERSITY_PAIRS 256  // sampled pairs of the population per JSON line
+
+#ifdef TELEMETRY
+#define PROBE(...) __VA_ARGS__
+#define PHASE(total) phase_timer phase(total)
+#else
+#define PROBE(...)
+#define PHASE(total)
+#endif
+
+#include "common.h"
+
+// the state of one solve. libmaxcut.a keeps a copy per thread, so solves on different threads
+// share nothing, see maxcut.h. the command line solves one graph in plain globals
+#ifdef MAXCUT_LIBRARY
+#define SOLVER_STATE thread_local
+#else
+#define SOLVER_STATE
+#endif
+
+// nothing but main() and the maxcut:: API is visible outside
+namespace {
+
+SOLVER_STATE double starts_at;
+SOLVER_STATE bool quiet;  // no progress lines on stderr, set for library solves unless Solver::verbose
+
+SOLVER_STATE int V;
+SOLVER_STATE int64_t E;
+SOLVER_STATE int W;  // 64-bit words per chromosome
+SOLVER_STATE uint64_t last_mask;  // valid bits of the last word
+SOLVER_STATE bool unit_weights;
+SOLVER_STATE int64_t total_weight;
+SOLVER_STATE int max_gain;  // largest sum of |w| around a vertex, bounds every gain
+SOLVER_STATE bool use_buckets;
+SOLVER_STATE bool cache_gains;  // chromosomes carry degrees[] of local_opt() behind their genes
+SOLVER_STATE int gain_cache_mb = GAIN_CACHE_MB;
+SOLVER_STATE int population_mb = POPULATION_MB;
+SOLVER_STATE int population_size;  // MAX_POPULATION unless limited by population_mb
+SOLVER_STATE int num_islands = 1;  // -I: populations on their own threads exchanging migrants, 1 is one shared population
+SOLVER_STATE enum { GREEDY_SEARCH, TABU_SEARCH } local_search;  // what local_opt() does after the descent, -l
+const char *local_search_names[] = {"greedy", "tabu"};
+SOLVER_STATE int tabu_iterations = TABU_ITERATIONS;
+SOLVER_STATE double tabu_seconds;  // time budget of one tabu search if > 0, -u
+// edge list split into u/v/w arrays plus compressed sparse row adjacency,
+// read by get_input() and laid out in the final order by renumber()
+class graph {
+public:
+	std::vector<int> edge_u, edge_v, edge_w;  // edge_w is dropped by compact_weights() like weights
+	std::vector<int64_t> offsets;  // neighbours of u are neighbors[offsets[u]] .. neighbors[offsets[u + 1] - 1]
+	std::vector<int> neighbors, weights;  // weights is dropped by compact_weights() if a policy does without
+	std::vector<uint64_t> signs;  // bit i set if weights[i] < 0, only for sign_weight
+	std::vector<uint64_t> edge_signs;  // bit i set if edge_w[i] < 0, only for sign_weight
+
+	// counting sort of both directions of every edge by their first end,
+	// over the edges this graph holds, which need not be E of the global one
+	void build_adjacency() {
+		int64_t E = edge_u.size();
+		offsets.assign(V + 1, 0);
+		for (int64_t i = 0; i < E; i++) {
+			offsets[edge_u[i] + 1]++;
+			offsets[edge_v[i] + 1]++;
+		}
+		for (int i = 0; i < V; i++)
+			offsets[i + 1] += offsets[i];
+		neighbors.resize(2 * E);
+		weights.resize(2 * E);
+		std::vector<int64_t> fill(offsets.begin(), offsets.end() - 1);
+		for (int64_t i = 0; i < E; i++) {
+			neighbors[fill[edge_u[i]]] = edge_v[i];
+			weights[fill[edge_u[i]]++] = edge_w[i];
+			neighbors[fill[edge_v[i]]] = edge_u[i];
+			weights[fill[edge_v[i]]++] = edge_w[i];
+		}
+	}
+
+	// order the neighbours of every vertex by key(neighbour)
+	template <class key_function>
+	void sort_rows(key_function key) {
+		std::vector<std::pair<int, int>> row;
+		for (int u = 0; u < V; u++) {
+			row.clear();
+			for (int64_t i = offsets[u]; i < offsets[u + 1]; i++)
+				row.emplace_back(neighbors[i], weights[i]);
+			std::sort(row.begin(), row.end(),
+				[&](const std::pair<int, int> &x, const std::pair<int, int> &y) {
+					return key(x.first) < key(y.first);
+				}
+			);
+			for (int64_t i = offsets[u]; i < offsets[u + 1]; i++)
+				std::tie(neighbors[i], weights[i]) = row[i - offsets[u]];
+		}
+	}
+};
+SOLVER_STATE graph G;
+SOLVER_STATE std::priority_queue<std::pair<int, int>> Q;  // only for renumber()
+
+// how the hot loops read the weight of adjacency entry i, and the O(E) kernels the weight of edge i.
+// the solver and the kernels are instantiated once per policy and prepare() picks the class,
+// so unit and +-c graphs never load a weight array
+SOLVER_STATE int weight_c;  // |w| of every edge for sign_weight
+
+class unit_weight {
+public:
+	static int at(int64_t) {
+		return 1;
+	}
+
+	static int edge(int64_t) {
+		return 1;
+	}
+};
+
+class sign_weight {
+public:
+	static int at(int64_t i) {
+		return G.signs[i >> 6] >> (i & 63) & 1 ? -weight_c : weight_c;
+	}
+
+	static int edge(int64_t i) {
+		return G.edge_signs[i >> 6] >> (i & 63) & 1 ? -weight_c : weight_c;
+	}
+};
+
+class stored_weight {
+public:
+	static int at(int64_t i) {
+		return G.weights[i];
+	}
+
+	static int edge(int64_t i) {
+		return G.edge_w[i];
+	}
+};
+
+SOLVER_STATE enum { UNIT_WEIGHTS, SIGN_WEIGHTS, STORED_WEIGHTS, NUM_WEIGHT_CLASSES } weight_class;
+const char *weight_class_names[] = {"unit", "sign", "stored"};
+
+SOLVER_STATE std::vector<uint64_t> zobrist;  // random key per vertex, a chromosome's key is the xor over its 1-genes
+SOLVER_STATE uint64_t zobrist_all;  // xor of all keys, the key of the complement is key ^ zobrist_all
+SOLVER_STATE int renumber_cnt;
+SOLVER_STATE std::vector<uint8_t> visits;
+SOLVER_STATE std::vector<int> renumbers, real_numbers;
+SOLVER_STATE std::vector<int> leftmost;  // smallest vertex having an edge over position i (i - 1 to i), V + 1 entries
+
+// xorshift64*, each thread owns one instead of sharing rand()
+class random_generator {
+public:
+	uint64_t state;
+
+	random_generator(uint64_t seed = 0) {
+		state = seed * 0x9E3779B97F4A7C15ULL + 0x2545F4914F6CDD1DULL;
+		if (state == 0) state = 1;
+	}
+
+	uint32_t next() {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return (state * 0x2545F4914F6CDD1DULL) >> 32;
+	}
+
+	int operator()(int n) {
+		return next() % n;
+	}
+};
+
+// seeds every other generator and picks the random choices of the setup, -s
+SOLVER_STATE random_generator seeder;
+
+// vertices with positive gain in one list per gain value, for integer gains up to max_gain.
+// top only moves down while popping and up by at most 2w per update
+class gain_buckets {
+public:
+	const int *keys;
+	int top;
+	std::vector<int> head, next, prev, slot;  // prev[v] = -2 if v is not in a bucket
+	PROBE(long long updates = 0, noops = 0;)  // noops left the buckets as they were
+
+	void init(int n, int max_key) {
+		head.assign(max_key + 1, -1);
+		next.resize(n);
+		prev.assign(n, -2);
+		slot.resize(n);
+		top = 0;
+	}
+
+	// all buckets are empty here, local_opt() always pops until nothing is left
+	void reset(const int *keys_) {
+		keys = keys_;
+		for (int v = 0; v < V; v++)
+			if (keys[v] > 0)
+				link(v, keys[v]);
+	}
+
+	void update(int v) {
+		PROBE(updates++);
+		if (prev[v] != -2) {
+			if (slot[v] == keys[v]) {
+				PROBE(noops++);
+				return;
+			}
+			unlink(v);
+		} else if (keys[v] <= 0) {
+			PROBE(noops++);
+			return;
+		}
+		if (keys[v] > 0)
+			link(v, keys[v]);
+	}
+
+	// empty the buckets for the next reset()
+	void clear() {
+		for (; top > 0; top--)
+			for (; head[top] >= 0; head[top] = next[head[top]])
+				prev[head[top]] = -2;
+	}
+
+	// the vertex pop() would return, left in its bucket
+	int peek() {
+		while (top > 0 && head[top] < 0)
+			top--;
+		return top ? head[top] : -1;
+	}
+
+	// vertex with the largest gain, -1 if no gain is positive
+	int pop() {
+		while (top > 0 && head[top] < 0)
+			top--;
+		if (top == 0) return -1;
+		int v = head[top];
+		unlink(v);
+		return v;
+	}
+
+	void link(int v, int key) {
+		next[v] = head[key];
+		prev[v] = -1;
+		if (head[key] >= 0)
+			prev[head[key]] = v;
+		head[key] = v;
+		slot[v] = key;
+		top = std::max(top, key);
+	}
+
+	void unlink(int v) {
+		if (prev[v] == -1)
+			head[slot[v]] = next[v];
+		else
+			next[prev[v]] = next[v];
+		if (next[v] >= 0)
+			prev[next[v]] = prev[v];
+		prev[v] = -2;
+	}
+};
+
+#ifdef TELEMETRY
+long long now_ns() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+// adds the nanoseconds of its scope to total
+class phase_timer {
+public:
+	long long &total, start;
+
+	phase_timer(long long &total_) : total(total_), start(now_ns()) {}
+	~phase_timer() { total += now_ns() - start; }
+};
+
+// counts in log2 bins: 0, 1, 2-3, 4-7, ...
+class histogram {
+public:
+	long long bins[TELEMETRY_BINS] = {};
+
+	void add(long long x) {
+		bins[std::min(x ? 64 - __builtin_clzll(x) : 0, TELEMETRY_BINS - 1)]++;
+	}
+
+	histogram &operator+=(const histogram &other) {
+		for (int i = 0; i < TELEMETRY_BINS; i++)
+			bins[i] += other.bins[i];
+		return *this;
+	}
+};
+
+// what one thread spent on children, summed over the threads when printed
+class probes {
+public:
+	long long crossover = 0, mutation = 0, local_opt = 0, busy = 0;  // ns
+	long long updates = 0, noops = 0;  // gain queue updates during local_opt()
+	histogram flips, queue_updates;  // per local_opt()
+};
+
+// what the thread running a population spent between and on replace()
+class population_probes {
+public:
+	long long generate = 0, replace = 0, insert = 0, release = 0;  // ns
+	long long duplicates = 0, accepted = 0;  // children dropped as twins, children that got in
+};
+
+SOLVER_STATE long long renumber_pops, renumber_stale;  // Q in renumber() is lazy, old entries are skipped
+
+// adds the nanoseconds since t to total and restarts t
+void lap(long long &total, long long &t) {
+	long long now = now_ns();
+	total += now - t;
+	t = now;
+}
+#endif
+
+SOLVER_STATE bool profile;  // -P: hardware counters per phase, printed at the end
+
+enum { PERF_INIT, PERF_CROSSOVER, PERF_LOCAL_OPT, PERF_REPLACE, NUM_PERF_PHASES };
+enum { PERF_CYCLES, PERF_INSTRUCTIONS, PERF_BRANCH_MISSES, PERF_L1D_MISSES, PERF_LLC_MISSES, NUM_PERF_EVENTS };
+const char *perf_phase_names[NUM_PERF_PHASES] = {"init", "crossover", "local_opt", "replace"};
+const char *perf_event_names[NUM_PERF_EVENTS] = {"cycles", "instructions", "branch_misses", "l1d_misses", "llc_misses"};
+
+// one counter group per phase for the thread that opened it, enabled only inside the phase.
+// user space only, so perf_event_paranoid up to 2 is enough
+class perf_counters {
+public:
+	int fds[NUM_PERF_PHASES][NUM_PERF_EVENTS];  // -1 if the event is not supported, fds[p][0] leads
+
+	// false if not even cycles can be counted
+	bool open() {
+		for (auto &phase : fds)
+			std::fill(phase, phase + NUM_PERF_EVENTS, -1);
+		static const uint32_t types[NUM_PERF_EVENTS] = {
+			PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, PERF_TYPE_HW_CACHE};
+		static const uint64_t configs[NUM_PERF_EVENTS] = {
+			PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_BRANCH_MISSES,
+			PERF_COUNT_HW_CACHE_L1D | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16,
+			PERF_COUNT_HW_CACHE_LL | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16};
+		for (int p = 0; p < NUM_PERF_PHASES; p++)
+			for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+				struct perf_event_attr attr;
+				std::memset(&attr, 0, sizeof(attr));
+				attr.size = sizeof(attr);
+				attr.type = types[e];
+				attr.config = configs[e];
+				attr.disabled = e == 0;
+				attr.exclude_kernel = 1;
+				attr.exclude_hv = 1;
+				attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+				fds[p][e] = syscall(SYS_perf_event_open, &attr, 0, -1, e ? fds[p][0] : -1, 0);
+				if (fds[p][0] < 0) return false;
+			}
+		return true;
+	}
+
+	void enable(int phase) {
+		ioctl(fds[phase][0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+	}
+
+	void disable(int phase) {
+		ioctl(fds[phase][0], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+	}
+
+	// adds the counts to totals, scaled up if the kernel had to multiplex counters
+	void add_to(double totals[NUM_PERF_PHASES][NUM_PERF_EVENTS]) {
+		for (int p = 0; p < NUM_PERF_PHASES; p++)
+			for (int e = 0; e < NUM_PERF_EVENTS; e++) {
+				uint64_t values[3];  // value, time enabled, time running
+				if (totals[p][e] < 0) continue;
+				if (fds[p][e] < 0 || read(fds[p][e], values, sizeof(values)) != sizeof(values)) {
+					totals[p][e] = -1;
+					continue;
+				}
+				if (values[2])
+					totals[p][e] += (double)values[0] * values[1] / values[2];
+			}
+	}
+};
+
+// counts its scope into one phase of the thread's counters if -P is given
+class perf_scope {
+public:
+	perf_counters &counters;
+	int phase;
+
+	perf_scope(perf_counters &counters_, int phase_) : counters(counters_), phase(phase_) {
+		if (profile) counters.enable(phase);
+	}
+
+	~perf_scope() {
+		if (profile) counters.disable(phase);
+	}
+};
+
+// per-thread scratch state, local_opt() writes only here
+class workspace {
+public:
+	random_generator rng;
+	std::vector<int> degrees;
+	gain_heap heap;
+	gain_buckets buckets;
+	std::vector<int> tabu_keys, tabu_until, tabu_list, trail;  // tabu search only
+	long long children = 0, local_opts = 0;  // summed up by -S
+	PROBE(probes probe;)
+	perf_counters perf;
+
+	workspace(uint64_t seed) : rng(seed), degrees(V) {
+		// tabu search queues every gain shifted by max_gain + 1
+		int max_key = local_search == TABU_SEARCH ? 2 * max_gain + 1 : max_gain;
+		if (use_buckets)
+			buckets.init(V, max_key);
+		else
+			heap.init(V);
+		if (local_search == TABU_SEARCH) {
+			tabu_keys.resize(V);
+			tabu_until.resize(V);
+		}
+	}
+};
+
+// the O(E) scans over the edge list: the cut of a chromosome, and with it the gains of all vertices.
+// the vector versions gather the 32-bit words holding both ends of 8 or 16 edges, shift the end bits
+// down and mask the weights with their xor, so there is no branch per edge.
+// gains are still added one edge at a time, two edges of a vector may share a vertex.
+// every kernel is instantiated per weight class: unit weights load no weights at all,
+// +-c weights expand edge_signs, 64 edges per word, and only stored weights read edge_w
+
+// cut flags of 64 edges are packed into one word, unit weights then only need a popcount per word
+// and +-c weights two, with the sign bits of the same 64 edges
+template <class weight>
+int64_t evaluate_scalar(const uint64_t *genes) {
+	int64_t score = 0;
+	const int *us = G.edge_u.data(), *vs = G.edge_v.data();
+	for (int64_t i = 0; i < E; i += 64) {
+		int64_t end = std::min(i + 64, E);
+		uint64_t cut = 0;
+		for (int64_t j = i; j < end; j++)
+			cut |= (uint64_t)((genes[us[j] >> 6] >> (us[j] & 63) ^ genes[vs[j] >> 6] >> (vs[j] & 63)) & 1) << (j - i);
+		if constexpr (std::is_same<weight, unit_weight>::value) {
+			score += __builtin_popcountll(cut);
+		} else if constexpr (std::is_same<weight, sign_weight>::value) {
+			uint64_t negative = G.edge_signs[i >> 6];
+			score += (int64_t)weight_c * (__builtin_popcountll(cut & ~negative) - __builtin_popcountll(cut & negative));
+		} else {
+			for (; cut; cut &= cut - 1)
+				score += weight::edge(i + __builtin_ctzll(cut));
+		}
+	}
+	return score;
+}
+
+// edges [from, E), the tail the vector versions leave over
+template <class weight>
+int64_t gains_scalar_from(const uint64_t *genes, int *degrees, int64_t from) {
+	int64_t score = 0;
+	const int *us = G.edge_u.data(), *vs = G.edge_v.data();
+	for (int64_t i = from; i < E; i++) {
+		int w = weight::edge(i);
+		if ((genes[us[i] >> 6] >> (us[i] & 63) ^ genes[vs[i] >> 6] >> (vs[i] & 63)) & 1) {
+			score += w;
+			degrees[us[i]] -= w;
+			degrees[vs[i]] -= w;
+		} else {
+			degrees[us[i]] += w;
+			degrees[vs[i]] += w;
+		}
+	}
+	return score;
+}
+
+template <class weight>
+int64_t gains_scalar(const uint64_t *genes, int *degrees) {
+	return gains_scalar_from<weight>(genes, degrees, 0);
+}
+
+// 1 in every lane whose edge is cut. bit i of the 64-bit genes is bit i & 31 of 32-bit word i >> 5
+__attribute__((target("avx2")))
+inline __m256i cut_avx2(const int *words, const int *us, const int *vs, int64_t i) {
+	const __m256i low = _mm256_set1_epi32(31);
+	__m256i u = _mm256_loadu_si256((const __m256i *)(us + i));
+	__m256i v = _mm256_loadu_si256((const __m256i *)(vs + i));
+	__m256i gu = _mm256_i32gather_epi32(words, _mm256_srli_epi32(u, 5), 4);
+	__m256i gv = _mm256_i32gather_epi32(words, _mm256_srli_epi32(v, 5), 4);
+	__m256i x = _mm256_xor_si256(_mm256_srlv_epi32(gu, _mm256_and_si256(u, low)),
+	                             _mm256_srlv_epi32(gv, _mm256_and_si256(v, low)));
+	return _mm256_and_si256(x, _mm256_set1_epi32(1));
+}
+
+// weights of edges i .. i + 7, i a multiple of 8, so their sign bits are one byte of edge_signs
+template <class weight>
+__attribute__((target("avx2")))
+inline __m256i weights_avx2(int64_t i) {
+	if constexpr (std::is_same<weight, unit_weight>::value) {
+		return _mm256_set1_epi32(1);
+	} else if constexpr (std::is_same<weight, sign_weight>::value) {
+		const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+		__m256i byte = _mm256_set1_epi32(G.edge_signs[i >> 6] >> (i & 63) & 0xFF);
+		__m256i negative = _mm256_cmpeq_epi32(_mm256_and_si256(byte, bits), bits);
+		__m256i c = _mm256_set1_epi32(weight_c);
+		return _mm256_sub_epi32(_mm256_xor_si256(c, negative), negative);
+	} else {
+		return _mm256_loadu_si256((const __m256i *)(G.edge_w.data() + i));
+	}
+}
+
+__attribute__((target("avx2")))
+inline __m256i add_epi32_to_epi64_avx2(__m256i sum, __m256i x) {
+	sum = _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(x)));
+	return _mm256_add_epi64(sum, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(x, 1)));
+}
+
+__attribute__((target("avx2")))
+inline int64_t sum_epi64_avx2(__m256i sum) {
+	int64_t lanes[4];
+	_mm256_storeu_si256((__m256i *)lanes, sum);
+	return lanes[0] + lanes[1] + lanes[2] + lanes[3];
+}
+
+template <class weight>
+__attribute__((target("avx2")))
+int64_t evaluate_avx2(const uint64_t *genes) {
+	const int *words = (const int *)genes;
+	const int *us = G.edge_u.data(), *vs = G.edge_v.data();
+	__m256i sum = _mm256_setzero_si256();
+	int64_t i = 0;
+	for (; i + 8 <= E; i += 8) {
+		__m256i cut = cut_avx2(words, us, vs, i);
+		if constexpr (std::is_same<weight, unit_weight>::value)
+			sum = add_epi32_to_epi64_avx2(sum, cut);
+		else
+			sum = add_epi32_to_epi64_avx2(sum, _mm256_and_si256(weights_avx2<weight>(i),
+			                                                    _mm256_sub_epi32(_mm256_setzero_si256(), cut)));
+	}
+	int64_t score = sum_epi64_avx2(sum);
+	for (; i < E; i++)
+		if ((genes[us[i] >> 6] >> (us[i] & 63) ^ genes[vs[i] >> 6] >> (vs[i] & 63)) & 1)
+			score += weight::edge(i);
+	return score;
+}
+
+template <class weight>
+__attribute__((target("avx2")))
+int64_t gains_avx2(const uint64_t *genes, int *degrees) {
+	const int *words = (const int *)genes;
+	const int *us = G.edge_u.data(), *vs = G.edge_v.data();
+	__m256i sum = _mm256_setzero_si256();
+	alignas(32) int deltas[8];
+	int64_t i = 0;
+	for (; i + 8 <= E; i += 8) {
+		__m256i cut = cut_avx2(words, us, vs, i);
+		__m256i negate = _mm256_sub_epi32(_mm256_setzero_si256(), cut);
+		__m256i w = weights_avx2<weight>(i);
+		sum = add_epi32_to_epi64_avx2(sum, _mm256_and_si256(w, negate));
+		// -w on cut edges, w on the others
+		_mm256_store_si256((__m256i *)deltas, _mm256_add_epi32(_mm256_xor_si256(w, negate), cut));
+		for (int j = 0; j < 8; j++) {
+			degrees[us[i + j]] += deltas[j];
+			degrees[vs[i + j]] += deltas[j];
+		}
+	}
+	return sum_epi64_avx2(sum) + gains_scalar_from<weight>(genes, degrees, i);
+}
+
+__attribute__((target("avx512f")))
+inline __mmask16 cut_avx512(const int *words, const int *us, const int *vs, int64_t i) {
+	const __m512i low = _mm512_set1_epi32(31);
+	__m512i u = _mm512_loadu_si512(us + i);
+	__m512i v = _mm512_loadu_si512(vs + i);
+	__m512i gu = _mm512_i32gather_epi32(_mm512_srli_epi32(u, 5), words, 4);
+	__m512i gv = _mm512_i32gather_epi32(_mm512_srli_epi32(v, 5), words, 4);
+	__m512i x = _mm512_xor_si512(_mm512_srlv_epi32(gu, _mm512_and_si512(u, low)),
+	                             _mm512_srlv_epi32(gv, _mm512_and_si512(v, low)));
+	return _mm512_test_epi32_mask(x, _mm512_set1_epi32(1));
+}
+
+// weights of edges i .. i + 15, i a multiple of 16, so their sign bits are a mask already
+template <class weight>
+__attribute__((target("avx512f")))
+inline __m512i weights_avx512(int64_t i) {
+	if constexpr (std::is_same<weight, unit_weight>::value) {
+		return _mm512_set1_epi32(1);
+	} else if constexpr (std::is_same<weight, sign_weight>::value) {
+		__m512i c = _mm512_set1_epi32(weight_c);
+		return _mm512_mask_sub_epi32(c, (__mmask16)(G.edge_signs[i >> 6] >> (i & 63)), _mm512_setzero_si512(), c);
+	} else {
+		return _mm512_loadu_si512(G.edge_w.data() + i);
+	}
+}
+
+__attribute__((target("avx512f")))
+inline __m512i add_epi32_to_epi64_avx512(__m512i sum, __m512i x) {
+	sum = _mm512_add_epi64(sum, _mm512_cvtepi32_epi64(_mm512_castsi512_si256(x)));
+	return _mm512_add_epi64(sum, _mm512_cvtepi32_epi64(_mm512_extracti64x4_epi64(x, 1)));
+}
+
+template <class weight>
+__attribute__((target("avx512f")))
+int64_t evaluate_avx512(const uint64_t *genes) {
+	const int *words = (const int *)genes;
+	const int *us = G.edge_u.data(), *vs = G.edge_v.data();
+	__m512i sum = _mm512_setzero_si512();
+	int64_t score = 0, i = 0;
+	for (; i + 16 <= E; i += 16) {
+		__mmask16 cut = cut_avx512(words, us, vs, i);
+		if constexpr (std::is_same<weight, unit_weight>::value)
+			score += __builtin_popcount(cut);
+		else
+			sum = add_epi32_to_epi64_avx512(sum, _mm512_maskz_mov_epi32(cut, weights_avx512<weight>(i)));
+	}
+	score += _mm512_reduce_add_epi64(sum);
+	for (; i < E; i++)
+		if ((genes[us[i] >> 6] >> (us[i] & 63) ^ genes[vs[i] >> 6] >> (vs[i] & 63)) & 1)
+			score += weight::edge(i);
+	return score;
+}
+
+template <class weight>
+__attribute__((target("avx512f")))
+int64_t gains_avx512(const uint64_t *genes, int *degrees) {
+	const int *words = (const int *)genes;
+	const int *us = G.edge_u.data(), *vs = G.edge_v.data();
+	__m512i sum = _mm512_setzero_si512();
+	alignas(64) int deltas[16];
+	int64_t i = 0;
+	for (; i + 16 <= E; i += 16) {
+		__mmask16 cut = cut_avx512(words, us, vs, i);
+		__m512i w = weights_avx512<weight>(i);
+		sum = add_epi32_to_epi64_avx512(sum, _mm512_maskz_mov_epi32(cut, w));
+		// -w on cut edges, w on the others
+		_mm512_store_si512(deltas, _mm512_mask_sub_epi32(w, cut, _mm512_setzero_si512(), w));
+		for (int j = 0; j < 16; j++) {
+			degrees[us[i + j]] += deltas[j];
+			degrees[vs[i + j]] += deltas[j];
+		}
+	}
+	return _mm512_reduce_add_epi64(sum) + gains_scalar_from<weight>(genes, degrees, i);
+}
+
+class kernel {
+public:
+	const char *name;
+	const char *feature;  // for __builtin_cpu_supports(), nullptr if any CPU runs it
+	int64_t (*evaluate[NUM_WEIGHT_CLASSES])(const uint64_t *genes);  // per weight_class
+	int64_t (*gains[NUM_WEIGHT_CLASSES])(const uint64_t *genes, int *degrees);
+
+	bool supported() const {
+		if (!feature) return true;
+		__builtin_cpu_init();
+		return strcmp(feature, "avx2") == 0 ? __builtin_cpu_supports("avx2") : __builtin_cpu_supports("avx512f");
+	}
+};
+
+// fastest last
+const kernel kernels[] = {
+	{"scalar", nullptr,
+	 {evaluate_scalar<unit_weight>, evaluate_scalar<sign_weight>, evaluate_scalar<stored_weight>},
+	 {gains_scalar<unit_weight>, gains_scalar<sign_weight>, gains_scalar<stored_weight>}},
+	{"avx2", "avx2",
+	 {evaluate_avx2<unit_weight>, evaluate_avx2<sign_weight>, evaluate_avx2<stored_weight>},
+	 {gains_avx2<unit_weight>, gains_avx2<sign_weight>, gains_avx2<stored_weight>}},
+	{"avx512", "avx512f",
+	 {evaluate_avx512<unit_weight>, evaluate_avx512<sign_weight>, evaluate_avx512<stored_weight>},
+	 {gains_avx512<unit_weight>, gains_avx512<sign_weight>, gains_avx512<stored_weight>}},
+};
+const int num_kernels = sizeof(kernels) / sizeof(kernels[0]);
+
+// the kernel of the weight class, set by select_kernel() once prepare() knows the class
+SOLVER_STATE int64_t (*evaluate_kernel)(const uint64_t *genes);
+SOLVER_STATE int64_t (*gains_kernel)(const uint64_t *genes, int *degrees);
+
+// the fastest kernel this CPU runs, or the one named by -k
+void select_kernel(const char *name) {
+	const kernel *chosen = nullptr;
+	for (auto &k : kernels)
+		if (k.supported() && (name ? strcmp(k.name, name) == 0 : true))
+			chosen = &k;
+	if (!chosen) {
+		fprintf(stderr, "kernel %s is unknown or not supported here\n", name);
+#ifdef MAXCUT_LIBRARY
+		throw std::invalid_argument(name);
+#else
+		exit(EINVAL);
+#endif
+	}
+	evaluate_kernel = chosen->evaluate[weight_class];
+	gains_kernel = chosen->gains[weight_class];
+	if (!quiet)
+		fprintf(stderr, "kernel: %s\n", chosen->name);
+}
+
+// every supported kernel of the weight class against the scalar one on random partitions,
+// with the time each took. needs the weights as compact_weights() left them
+bool verify_kernels() {
+	random_generator rng(1);
+	std::vector<uint64_t> genes(W);
+	std::vector<int> expected(V), degrees(V);
+	std::vector<double> seconds(num_kernels);
+	bool ok = true;
+	for (int t = 0; t < 64; t++) {
+		for (auto &word : genes)
+			word = t == 0 ? 0 : t == 1 ? ~0ULL : (uint64_t)rng.next() << 32 | rng.next();
+		genes[W - 1] &= last_mask;
+		std::fill(expected.begin(), expected.end(), 0);
+		int64_t cut = kernels[0].gains[weight_class](genes.data(), expected.data());
+		for (int k = 0; k < num_kernels; k++) {
+			if (!kernels[k].supported()) continue;
+			std::fill(degrees.begin(), degrees.end(), 0);
+			double at = get_time();
+			int64_t score = kernels[k].evaluate[weight_class](genes.data());
+			int64_t gains_score = kernels[k].gains[weight_class](genes.data(), degrees.data());
+			seconds[k] += get_time() - at;
+			if (score != cut || gains_score != cut || degrees != expected) {
+				fprintf(stderr, "kernel %s differs from scalar on partition %d\n", kernels[k].name, t);
+				ok = false;
+			}
+		}
+	}
+	for (int k = 0; k < num_kernels; k++)
+		if (kernels[k].supported())
+			fprintf(stderr, "kernel %s: %.3lf ms per evaluate + gains\n", kernels[k].name, seconds[k] / 64 * 1e3);
+		else
+			fprintf(stderr, "kernel %s: not supported\n", kernels[k].name);
+	return ok;
+}
+
+// fixed-size chromosome slots carved out of large mappings and never unmapped during a solve.
+// evicted chromosomes go to a per-thread free list and are reused by the next children,
+// so the steady state does no malloc/free and takes the lock once per POOL_BATCH slots
+class chromosome_pool {
+public:
+	size_t slot_size = 0, chunk_size = 0;
+	bool huge_pages;
+	std::mutex mutex;
+	std::vector<void *> shared;  // free slots not owned by any thread
+	std::vector<void *> mapped;  // every chunk, for init() of the next solve
+	std::atomic<long> live{0}, peak{0};
+	long slots = 0, chunks = 0;
+
+	struct thread_cache {
+		std::vector<void *> slots;
+		~thread_cache();
+	};
+	static thread_local thread_cache cache;
+
+	// a pool left by an earlier solve of this thread has no live slot. its chunks are carved
+	// into the new slots if they have the same size, and unmapped otherwise
+	void init(size_t size, bool huge) {
+		size_t old_chunk_size = chunk_size;
+		slot_size = (size + 63) / 64 * 64;
+		chunk_size = (std::max(slot_size, (size_t)POOL_CHUNK) + POOL_CHUNK - 1) / POOL_CHUNK * POOL_CHUNK;
+		huge_pages = huge;
+		cache.slots.clear();
+		shared.clear();
+		slots = chunks = 0;
+		live = peak = 0;  // slots of a solve that threw are taken back too
+		std::vector<void *> old;
+		old.swap(mapped);
+		for (void *chunk : old)
+			if (old_chunk_size == chunk_size)
+				carve(chunk);
+			else
+				munmap(chunk, old_chunk_size);
+	}
+
+#ifdef MAXCUT_LIBRARY
+	// the pool of a library thread goes with the thread, or with maxcut::release()
+	~chromosome_pool() {
+		for (void *chunk : mapped)
+			munmap(chunk, chunk_size);
+	}
+
+	// cache may be gone already when the destructor runs, so only here
+	void unmap() {
+		for (void *chunk : mapped)
+			munmap(chunk, chunk_size);
+		std::vector<void *>().swap(mapped);
+		std::vector<void *>().swap(cache.slots);
+		std::vector<void *>().swap(shared);
+		slots = chunks = 0;
+	}
+#endif
+
+	void *allocate() {
+		auto &mine = cache.slots;
+		if (mine.empty())
+			refill(mine);
+		void *slot = mine.back();
+		mine.pop_back();
+		long now = live.fetch_add(1, std::memory_order_relaxed) + 1;
+		long before = peak.load(std::memory_order_relaxed);
+		while (now > before && !peak.compare_exchange_weak(before, now, std::memory_order_relaxed));
+		return slot;
+	}
+
+	void release(void *slot) {
+		auto &mine = cache.slots;
+		mine.push_back(slot);
+		live.fetch_sub(1, std::memory_order_relaxed);
+		if (mine.size() >= 2 * POOL_BATCH) {
+			std::lock_guard<std::mutex> lock(mutex);
+			shared.insert(shared.end(), mine.end() - POOL_BATCH, mine.end());
+			mine.resize(mine.size() - POOL_BATCH);
+		}
+	}
+
+	void refill(std::vector<void *> &mine) {
+		std::lock_guard<std::mutex> lock(mutex);
+		if (shared.empty())
+			map_chunk();
+		size_t n = std::min(shared.size(), (size_t)POOL_BATCH);
+		mine.insert(mine.end(), shared.end() - n, shared.end());
+		shared.resize(shared.size() - n);
+	}
+
+	// MAP_HUGETLB needs reserved huge pages, otherwise ask for transparent ones
+	void map_chunk() {
+		void *chunk = MAP_FAILED;
+		if (huge_pages)
+			chunk = mmap(nullptr, chunk_size, PROT_READ | PROT_WRITE,
+			             MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (chunk == MAP_FAILED) {
+			chunk = mmap(nullptr, chunk_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+			if (chunk == MAP_FAILED) {
+#ifdef MAXCUT_LIBRARY
+				throw std::bad_alloc();  // fails the solve, not the process running it
+#else
+				exit(ENOMEM);
+#endif
+			}
+			if (huge_pages)
+				madvise(chunk, chunk_size, MADV_HUGEPAGE);
+		}
+		carve(chunk);
+	}
+
+	void carve(void *chunk) {
+		size_t n = chunk_size / slot_size;
+		for (size_t i = n; i-- > 0;)
+			shared.push_back((char *)chunk + i * slot_size);
+		slots += n;
+		chunks++;
+		mapped.push_back(chunk);
+	}
+
+	void report() {
+		fprintf(stderr, "pool: %ld live, %ld peak, %ld slots of %zu bytes in %ld chunks (%.1lf MB)\n",
+		        live.load(), peak.load(), slots, slot_size, chunks, chunks * (double)chunk_size / 1048576);
+	}
+};
+SOLVER_STATE chromosome_pool pool;
+
+thread_local chromosome_pool::thread_cache chromosome_pool::cache;
+
+chromosome_pool::thread_cache::~thread_cache() {
+	if (slots.empty()) return;
+	std::lock_guard<std::mutex> lock(pool.mutex);
+	pool.shared.insert(pool.shared.end(), slots.begin(), slots.end());
+}
+
+SOLVER_STATE bool huge_pages;
+
+class chromosome {
+public:
+	int64_t score = INT64_MAX;
+	uint64_t key = 0;  // zobrist key, kept up to date on every gene change
+	uint64_t genes[];  // W words, gene i is bit (i & 63) of genes[i >> 6]
+
+	// genes[] is allocated right behind the object, only W words of it,
+	// followed by V gains if cache_gains is set
+	static size_t bytes() {
+		return sizeof(chromosome) + W * sizeof(uint64_t) + (cache_gains ? V * sizeof(int) : 0);
+	}
+
+	static void *operator new(size_t) {
+		return pool.allocate();
+	}
+
+	static void operator delete(void *ptr) {
+		pool.release(ptr);
+	}
+
+	chromosome(random_generator *rng = nullptr) {
+		if (rng) {
+			for (int i = 0; i < W; i++)
+				genes[i] = (uint64_t)rng->next() << 32 | rng->next();
+			genes[W - 1] &= last_mask;
+			for (int i = 0; i < W; i++)
+				for (uint64_t word = genes[i]; word; word &= word - 1)
+					key ^= zobrist[i * 64 + __builtin_ctzll(word)];
+		} else {
+			// bits past V must stay 0 like in every chromosome
+			std::memset(genes, 0, W * sizeof(uint64_t));
+		}
+	}
+
+	chromosome(chromosome *other) {
+		copy_genes(other);
+		if (cache_gains) {
+			score = other->score;
+			std::memcpy(gains(), other->gains(), V * sizeof(int));
+		}
+	}
+
+	int *gains() {
+		return (int *)(genes + W);
+	}
+
+	void copy_genes(chromosome *other) {
+		std::memcpy(genes, other->genes, W * sizeof(uint64_t));
+		key = other->key;
+	}
+
+	int get(int i) const {
+		return genes[i >> 6] >> (i & 63) & 1;
+	}
+
+	void flip(int i) {
+		genes[i >> 6] ^= 1ULL << (i & 63);
+		key ^= zobrist[i];
+	}
+
+	// overwrite genes[i] with the masked bits of word, the key follows the changed bits
+	void set_word(int i, uint64_t word, uint64_t mask) {
+		for (uint64_t diff = (genes[i] ^ word) & mask; diff; diff &= diff - 1)
+			key ^= zobrist[i * 64 + __builtin_ctzll(diff)];
+		genes[i] = (genes[i] & ~mask) | (word & mask);
+	}
+
+	void get_interval(chromosome *other, int left, int right, bool flip) {
+		if (left >= right) return;
+		uint64_t inv = flip ? ~0ULL : 0;
+		int lw = left >> 6, rw = (right - 1) >> 6;
+		uint64_t lmask = ~0ULL << (left & 63);
+		uint64_t rmask = ~0ULL >> (63 - ((right - 1) & 63));
+		if (lw == rw) {
+			set_word(lw, other->genes[lw] ^ inv, lmask & rmask);
+			return;
+		}
+		set_word(lw, other->genes[lw] ^ inv, lmask);
+		for (int i = lw + 1; i < rw; i++)
+			set_word(i, other->genes[i] ^ inv, ~0ULL);
+		set_word(rw, other->genes[rw] ^ inv, rmask);
+	}
+
+	template <class weight>
+	chromosome *crossover(chromosome *other, workspace &ws) {
+		int cp[CUTTING_POINT + 2];
+		cp[0] = 0;
+		cp[CUTTING_POINT + 1] = V;
+		for (int i = 1; i <= CUTTING_POINT; i++)
+			cp[i] = ws.rng(V);
+		// std::sort(cp + 1, cp + CUTTING_POINT + 1);
+		if (cp[1] > cp[2]) {
+			int temp = cp[1];
+			cp[1] = cp[2];
+			cp[2] = temp;
+		}
+		PHASE(ws.probe.crossover);
+		perf_scope perf(ws.perf, PERF_CROSSOVER);
+		// start from a copy of this and copy the intervals of other,
+		// so the key only follows the genes where the parents differ
+		chromosome *child = new chromosome();
+		child->copy_genes(this);
+		bool flip = ws.rng(2);
+		for (int i = 1; i <= CUTTING_POINT; i += 2)
+			child->get_interval(other, cp[i], cp[i + 1], flip);
+		if (cache_gains)
+			child->inherit_gains<weight>(this, other, cp[1], cp[2]);
+		return child;
+	}
+
+	// genes outside [left, right) are a's, genes inside are b's (maybe flipped).
+	// a gain only depends on which neighbours share the vertex's side,
+	// so the parents' gains stay valid except on edges over the two borders
+	template <class weight>
+	void inherit_gains(chromosome *a, chromosome *b, int left, int right) {
+		int *g = gains();
+		std::memcpy(g, a->gains(), left * sizeof(int));
+		std::memcpy(g + left, b->gains() + left, (right - left) * sizeof(int));
+		std::memcpy(g + right, a->gains() + right, (V - right) * sizeof(int));
+		if (left < right) {
+			for (int u = leftmost[left]; u < left; u++)
+				for (int64_t i = G.offsets[u]; i < G.offsets[u + 1]; i++)
+					if (G.neighbors[i] >= left && G.neighbors[i] < right)
+						fix_border(a, b, u, G.neighbors[i], weight::at(i));
+			for (int u = std::max(leftmost[right], left); u < right; u++)
+				for (int64_t i = G.offsets[u]; i < G.offsets[u + 1]; i++)
+					if (G.neighbors[i] >= right)
+						fix_border(b, a, u, G.neighbors[i], weight::at(i));
+		}
+		// sum of all gains is 2 * (total_weight - 2 * score)
+		int64_t sum = 0;
+		for (int i = 0; i < V; i++)
+			sum += g[i];
+		score = (2 * total_weight - sum) / 4;
+	}
+
+	// edge (u, v) whose ends come from p and q respectively
+	void fix_border(chromosome *p, chromosome *q, int u, int v, int w) {
+		int *g = gains();
+		int now = get(u) == get(v) ? w : -w;
+		g[u] += now - (p->get(u) == p->get(v) ? w : -w);
+		g[v] += now - (q->get(u) == q->get(v) ? w : -w);
+	}
+
+	template <class weight>
+	chromosome *mutation(bool create, workspace &ws) {
+		PHASE(ws.probe.mutation);
+		int idx = ws.rng(V);
+		if (create) {
+			chromosome *child = new chromosome(this);
+			child->flip_gains<weight>(idx);
+			return child;
+		} else {
+			flip_gains<weight>(idx);
+			return this;
+		}
+	}
+
+	// flip a gene, keeping cached gains and score up to date
+	template <class weight>
+	void flip_gains(int u) {
+		if (cache_gains)
+			move<weight>(u, gains(), [](int) {});
+		else
+			flip(u);
+	}
+
+	// flip u, add its gain to score and update the gains of u and its neighbours,
+	// changed(v) is called after the gain of each neighbour v moved
+	template <class weight, class callback>
+	void move(int u, int *degrees, callback changed) {
+		score += degrees[u];
+		int gene = get(u);
+		for (int64_t i = G.offsets[u]; i < G.offsets[u + 1]; i++) {
+			int v = G.neighbors[i], w = weight::at(i);
+			if (gene != get(v)) {
+				degrees[u] += 2 * w;
+				degrees[v] += 2 * w;
+			} else {
+				degrees[u] -= 2 * w;
+				degrees[v] -= 2 * w;
+			}
+			changed(v);
+		}
+		flip(u);
+	}
+
+	// full O(E) scan for score and gains of all vertices
+	void init_gains(int *degrees) {
+		std::memset(degrees, 0, V * sizeof(int));
+		score = gains_kernel(genes, degrees);
+	}
+
+	template <class weight>
+	chromosome *local_opt(workspace &ws) {
+		PHASE(ws.probe.local_opt);
+		perf_scope perf(ws.perf, PERF_LOCAL_OPT);
+		ws.local_opts++;
+		int *degrees;
+		if (cache_gains) {
+			degrees = gains();  // inherited from the parents, kept for the children
+		} else {
+			degrees = ws.degrees.data();
+			init_gains(degrees);
+		}
+		if (use_buckets) {
+			descend<weight>(degrees, ws.buckets, ws);
+			if (local_search == TABU_SEARCH)
+				tabu<weight>(degrees, ws.buckets, ws);
+		} else {
+			descend<weight>(degrees, ws.heap, ws);
+			if (local_search == TABU_SEARCH)
+				tabu<weight>(degrees, ws.heap, ws);
+		}
+		return this;
+	}
+
+	// flip the vertex of largest positive gain until there is none
+	template <class weight, class gain_queue>
+	void descend(int *degrees, gain_queue &Q, [[maybe_unused]] workspace &ws) {  // ws for the probes only
+		Q.reset(degrees);
+		PROBE(long long updates = Q.updates, noops = Q.noops);
+		PROBE(long long flips = 0);
+		int u;
+		// int cnt = 0;
+		while ((u = Q.pop()) >= 0) {
+		// while (cnt < NUM_LOCAL_OPT && (u = Q.pop()) >= 0) {
+			// cnt++;
+			PROBE(flips++);
+			move<weight>(u, degrees, [&](int v) { Q.update(v); });  // degrees[u] is negative now, it stays out of Q
+		}
+		PROBE(ws.probe.flips.add(flips));
+		PROBE(ws.probe.queue_updates.add(Q.updates - updates));
+		PROBE(ws.probe.updates += Q.updates - updates);
+		PROBE(ws.probe.noops += Q.noops - noops);
+	}
+
+	// tabu search from the local optimum of descend(): flip the vertex of largest gain that is not tabu,
+	// also at a loss, or a tabu one that makes a new best. a flipped vertex stays tabu for a random tenure.
+	// Q holds the gains shifted by max_gain + 1, so every key is positive, and 0 while a vertex is tabu.
+	// ends in the best partition seen, after tabu_iterations moves or tabu_seconds
+	template <class weight, class gain_queue>
+	void tabu(int *degrees, gain_queue &Q, workspace &ws) {
+		int *keys = ws.tabu_keys.data(), *until = ws.tabu_until.data();
+		std::vector<int> &tabu_list = ws.tabu_list, &trail = ws.trail;  // trail: flips since the best
+		for (int v = 0; v < V; v++)
+			keys[v] = degrees[v] + max_gain + 1;
+		Q.reset(keys);
+		tabu_list.clear();
+		trail.clear();
+		int64_t best = score;
+		double deadline = tabu_seconds > 0 ? get_time() + tabu_seconds : 0;
+		for (int it = 1; it <= tabu_iterations; it++) {
+			if (deadline && (it & 63) == 0 && get_time() > deadline) break;
+			// release expired vertices, and look for the best tabu move that makes a new best
+			int u = -1;
+			for (size_t j = 0; j < tabu_list.size();) {
+				int v = tabu_list[j];
+				if (until[v] <= it) {
+					tabu_list[j] = tabu_list.back();
+					tabu_list.pop_back();
+					keys[v] = degrees[v] + max_gain + 1;
+					Q.update(v);
+					continue;
+				}
+				if (score + degrees[v] > best && (u < 0 || degrees[v] > degrees[u]))
+					u = v;
+				j++;
+			}
+			// the aspirant only beats a better free move if it has the larger gain
+			int free = Q.peek();
+			if (u >= 0 && free >= 0 && degrees[free] >= degrees[u])
+				u = -1;
+			if (u < 0 && (u = Q.pop()) < 0) break;  // everything is tabu
+			if (keys[u]) {  // popped, otherwise already in tabu_list
+				keys[u] = 0;
+				tabu_list.push_back(u);
+			}
+			until[u] = it + V / 150 + 1 + ws.rng(TABU_TENURE);
+			move<weight>(u, degrees, [&](int v) {
+				if (keys[v]) {
+					keys[v] = degrees[v] + max_gain + 1;
+					Q.update(v);
+				}
+			});
+			if (score > best) {
+				best = score;
+				trail.clear();
+			} else {
+				trail.push_back(u);
+			}
+		}
+		Q.clear();
+		for (size_t j = trail.size(); j-- > 0;)
+			move<weight>(trail[j], degrees, [](int) {});
+	}
+
+	// key of whichever of this and its complement has gene 0 unset,
+	// so a chromosome and its complement hash alike
+	uint64_t hash() const {
+		return (genes[0] & 1) ? key ^ zobrist_all : key;
+	}
+
+	int64_t evaluate() {
+		if (score == INT64_MAX && cache_gains)
+			init_gains(gains());
+		if (score == INT64_MAX)
+			score = evaluate_kernel(genes);
+		return score;
+	}
+};
+
+class evaluation {
+public:
+	int64_t score;
+	uint64_t hash;
+	chromosome *chr;
+
+	evaluation() = default;
+	evaluation(chromosome *chr_) : chr(chr_) {
+		score = chr->evaluate();
+		hash = chr->hash();
+	}
+
+	// better than other, hashes break ties so no two members are equal
+	bool operator<(const evaluation &other) const {
+		return score > other.score ||
+		       (score == other.score && hash < other.hash);
+	}
+};
+
+// open addressing set of 64-bit hashes, linear probing with backward-shift deletion
+class hash_set {
+public:
+	std::vector<uint64_t> table;  // 0 marks an empty cell, hash 0 is kept in has_zero
+	uint64_t mask;
+	int shift;
+	bool has_zero = false;
+
+	void init(size_t n) {
+		size_t size = 1;
+		for (shift = 64; size < 2 * n; size <<= 1)
+			shift--;
+		table.assign(size, 0);
+		mask = size - 1;
+	}
+
+	size_t home(uint64_t h) const {
+		return (h * 0x9E3779B97F4A7C15ULL) >> shift;
+	}
+
+	// false if h was already there
+	bool insert(uint64_t h) {
+		if (h == 0) {
+			bool fresh = !has_zero;
+			has_zero = true;
+			return fresh;
+		}
+		size_t i = home(h);
+		for (; table[i]; i = (i + 1) & mask)
+			if (table[i] == h) return false;
+		table[i] = h;
+		return true;
+	}
+
+	void erase(uint64_t h) {
+		if (h == 0) {
+			has_zero = false;
+			return;
+		}
+		size_t i = home(h);
+		while (table[i] != h) {
+			if (table[i] == 0) return;
+			i = (i + 1) & mask;
+		}
+		// pull later entries of the probe run back into the hole
+		for (size_t j = (i + 1) & mask; table[j]; j = (j + 1) & mask) {
+			size_t k = home(table[j]);
+			if (((j - k) & mask) >= ((j - i) & mask)) {
+				table[i] = table[j];
+				i = j;
+			}
+		}
+		table[i] = 0;
+	}
+};
+
+class population {
+public:
+	int num_chrs;
+	std::vector<chromosome *> chrs, children;  // chrs[i] is evals[i].chr
+	std::vector<evaluation> evals;  // binary heap with the worst member on top
+	std::vector<uint64_t> dropped;  // hashes to forget at the end of replace()
+	evaluation top;  // the best member, only a better child can take its place
+	hash_set hashes;  // hashes of chrs[], duplicates never get in
+	PROBE(population_probes probe;)
+
+	population() = default;
+	population(random_generator &rng) {
+		allocate();
+		fill(rng);
+		heapify();
+	}
+
+	// random members up to population_size
+	void fill(random_generator &rng) {
+		for (int i = num_chrs; i < population_size; i++) {
+			chromosome *chr = new chromosome(&rng);
+			evaluation eval(chr);
+			if (hashes.insert(eval.hash))
+				evals[num_chrs++] = eval;
+			else
+				delete chr;
+		}
+	}
+
+	// after a stagnation: keep the elite best members, the others are random again
+	void restart(random_generator &rng, int elite) {
+		elite = std::min(elite, num_chrs);
+		std::partial_sort(evals.begin(), evals.begin() + elite, evals.begin() + num_chrs);
+		for (int i = elite; i < num_chrs; i++) {
+			hashes.erase(evals[i].hash);
+			delete evals[i].chr;
+		}
+		num_chrs = elite;
+		fill(rng);
+		heapify();
+	}
+
+	void allocate() {
+		chrs.assign(population_size, nullptr);
+		children.assign(NUM_CHILDREN, nullptr);
+		evals.resize(population_size);
+		hashes.init(population_size + NUM_CHILDREN);
+		dropped.reserve(NUM_CHILDREN);
+		num_chrs = 0;
+	}
+
+	// heap order, chrs[] and top once evals[0, num_chrs) are filled in
+	void heapify() {
+		std::make_heap(evals.begin(), evals.begin() + num_chrs);
+		top = evals[0];
+		for (int i = 0; i < num_chrs; i++) {
+			chrs[i] = evals[i].chr;
+			if (evals[i] < top)
+				top = evals[i];
+		}
+	}
+
+	// takes children[0, n) in, migrants use the same way.
+	// a child replaces the worst member if it is better, so only what changes is touched
+	// and the population ends up as the best population_size of members and children
+	void replace(int n = NUM_CHILDREN) {
+		PROBE(long long t = now_ns());
+		for (int i = 0; i < n; i++) {
+			evaluation eval(children[i]);
+			// children already alive, or twins of an earlier child, are dropped.
+			// hashes of dropped children stay until the end, so later twins see them
+			if (!hashes.insert(eval.hash)) {
+				PROBE(probe.duplicates++);
+				delete children[i];
+				continue;
+			}
+			if (num_chrs < population_size) {
+				evals[num_chrs] = eval;
+				chrs[num_chrs] = eval.chr;
+				sift_up(num_chrs++);
+			} else if (eval < evals[0]) {
+				dropped.push_back(evals[0].hash);
+				delete evals[0].chr;
+				evals[0] = eval;
+				chrs[0] = eval.chr;
+				sift_down(0);
+			} else {
+				dropped.push_back(eval.hash);
+				delete children[i];
+				continue;
+			}
+			PROBE(probe.accepted++);
+			if (eval < top)
+				top = eval;
+		}
+		PROBE(lap(probe.insert, t));
+		for (uint64_t h : dropped)
+			hashes.erase(h);
+		dropped.clear();
+		PROBE(lap(probe.release, t));
+	}
+
+	void sift_up(int i) {
+		evaluation eval = evals[i];
+		while (i > 0) {
+			int parent = (i - 1) / 2;
+			if (!(evals[parent] < eval)) break;
+			evals[i] = evals[parent];
+			chrs[i] = evals[i].chr;
+			i = parent;
+		}
+		evals[i] = eval;
+		chrs[i] = eval.chr;
+	}
+
+	void sift_down(int i) {
+		evaluation eval = evals[i];
+		while (2 * i + 1 < num_chrs) {
+			int child = 2 * i + 1;
+			if (child + 1 < num_chrs && evals[child] < evals[child + 1])
+				child++;
+			if (!(eval < evals[child])) break;
+			evals[i] = evals[child];
+			chrs[i] = evals[i].chr;
+			i = child;
+		}
+		evals[i] = eval;
+		chrs[i] = eval.chr;
+	}
+
+	// the k best members, best first, for migration
+	std::vector<chromosome *> best(int k) {
+		k = std::min(k, num_chrs);
+		std::vector<evaluation> sorted(evals.begin(), evals.begin() + num_chrs);
+		std::partial_sort(sorted.begin(), sorted.begin() + k, sorted.end());
+		std::vector<chromosome *> result(k);
+		for (int i = 0; i < k; i++)
+			result[i] = sorted[i].chr;
+		return result;
+	}
+};
+SOLVER_STATE population group;
+
+SOLVER_STATE bool renumbered;  // the input was a binary graph, renumber() is already done
+
+// what reduce() took out of the input graph, print_output() puts it back
+class reduction {
+public:
+	int input_V = 0;  // 0 if the graph was not reduced
+	int64_t offset = 0;  // cut of the folded edges, every score is reported with it
+	std::vector<std::tuple<int, int, bool>> folds;  // (u, v, opposite): u had only v left, in fold order
+	std::vector<std::vector<int>> components;  // input vertices of each component still to solve, ascending
+	std::vector<int> component, local;  // per input vertex: its component or -1, its index in there
+	std::vector<int> edge_u, edge_v, edge_w;  // merged edges between vertices of the components, by component
+	std::vector<int64_t> edges;  // edges of component k are edge_u/v/w[edges[k]] .. [edges[k + 1] - 1]
+};
+SOLVER_STATE reduction reduced;
+
+// skips to the next number and reads it, false at the end of the input
+template <class integer>
+inline bool read_int(const char *&p, const char *end, integer &x) {
+	while (p < end && (unsigned)(*p - '0') > 9 && *p != '-')
+		p++;
+	if (p == end) return false;
+	bool negative = *p == '-';
+	p += negative;
+	uint64_t value = 0;
+	unsigned digit;
+	while (p < end && (digit = (unsigned)(*p - '0')) <= 9) {
+		value = value * 10 + digit;
+		p++;
+	}
+	x = negative ? -(int64_t)value : value;
+	return true;
+}
+
+void parse_text(const char *p, const char *end) {
+	int u, v, w;
+	if (!read_int(p, end, V) || !read_int(p, end, E) || V <= 0 || E < 0) exit(EINVAL);
+	// an edge takes at least 6 characters, " u v w", so the input bounds what E may allocate
+	if (E > (end - p + 1) / 6) exit(EINVAL);
+	G.edge_u.resize(E);
+	G.edge_v.resize(E);
+	G.edge_w.resize(E);
+	int64_t kept = 0;
+	for (int64_t i = 0; i < E; i++) {
+		if (!read_int(p, end, u) || !read_int(p, end, v) || !read_int(p, end, w)) exit(EINVAL);
+		if (u < 1 || u > V || v < 1 || v > V) exit(EINVAL);
+		if (u == v) continue;  // a loop is never cut, and would break the gains
+		// change from 1-base to 0-base
+		G.edge_u[kept] = u - 1;
+		G.edge_v[kept] = v - 1;
+		G.edge_w[kept] = w;
+		kept++;
+	}
+	E = kept;
+	G.edge_u.resize(E);
+	G.edge_v.resize(E);
+	G.edge_w.resize(E);
+}
+
+// binary graph: BINARY_MAGIC, V, E, checksum of the rest, then real_numbers[V],
+// edge_u/v/w[E] as int32, offsets[V + 1] as int64, neighbors/weights[2E] as int32,
+// all in renumbered order
+struct binary_header {
+	char magic[8];
+	int64_t V, E;
+	uint64_t checksum;
+};
+
+uint64_t checksum(const char *data, size_t size) {
+	uint64_t h = 0xCBF29CE484222325ULL;
+	size_t i = 0;
+	for (uint64_t word; i + 8 <= size; i += 8) {
+		std::memcpy(&word, data + i, 8);
+		h = (h ^ word) * 0x100000001B3ULL;
+	}
+	for (; i < size; i++)
+		h = (h ^ (uint8_t)data[i]) * 0x100000001B3ULL;
+	return h;
+}
+
+// the checksum only catches damage, so every index is checked before it is used
+void read_binary(const char *data, size_t size) {
+	binary_header header;
+	std::memcpy(&header, data, sizeof(header));
+	auto corrupted = [] {
+		fprintf(stderr, "corrupted binary graph\n");
+		exit(EINVAL);
+	};
+	// the file bounds V and E before anything is sized by them
+	size_t rest = size - sizeof(header);
+	if (header.V <= 0 || header.V > INT32_MAX || header.E < 0 || (uint64_t)header.E > rest / (7 * sizeof(int32_t)))
+		corrupted();
+	V = header.V;
+	E = header.E;
+	const char *p = data + sizeof(header);
+	size_t payload = ((size_t)V + (size_t)7 * E) * sizeof(int32_t) + ((size_t)V + 1) * sizeof(int64_t);
+	if (rest != payload || checksum(p, payload) != header.checksum)
+		corrupted();
+	auto take = [&](auto *dst, size_t n) {
+		std::memcpy(dst, p, n * sizeof(*dst));
+		p += n * sizeof(*dst);
+	};
+	real_numbers.resize(V);
+	renumbers.assign(V, -1);
+	take(real_numbers.data(), V);
+	for (int i = 0; i < V; i++) {
+		if (real_numbers[i] < 0 || real_numbers[i] >= V || renumbers[real_numbers[i]] >= 0)
+			corrupted();  // not a permutation
+		renumbers[real_numbers[i]] = i;
+	}
+	for (auto array : {&G.edge_u, &G.edge_v, &G.edge_w}) {
+		array->resize(E);
+		take(array->data(), E);
+	}
+	for (int64_t i = 0; i < E; i++)
+		if (G.edge_u[i] < 0 || G.edge_u[i] >= V || G.edge_v[i] < 0 || G.edge_v[i] >= V)
+			corrupted();
+	G.offsets.resize(V + 1);
+	take(G.offsets.data(), V + 1);
+	if (G.offsets[0] != 0 || G.offsets[V] != 2 * E)
+		corrupted();
+	for (int i = 0; i < V; i++)
+		if (G.offsets[i] > G.offsets[i + 1])
+			corrupted();
+	for (auto array : {&G.neighbors, &G.weights}) {
+		array->resize(2 * E);
+		take(array->data(), 2 * E);
+	}
+	for (int v : G.neighbors)
+		if (v < 0 || v >= V)
+			corrupted();
+	renumbered = true;
+}
+
+void write_binary(const char *path) {
+	std::vector<char> payload;
+	auto put = [&](const auto *src, size_t n) {
+		payload.insert(payload.end(), (const char *)src, (const char *)(src + n));
+	};
+	put(real_numbers.data(), V);
+	put(G.edge_u.data(), E);
+	put(G.edge_v.data(), E);
+	put(G.edge_w.data(), E);
+	put(G.offsets.data(), V + 1);
+	put(G.neighbors.data(), 2 * E);
+	put(G.weights.data(), 2 * E);
+	binary_header header;
+	std::memcpy(header.magic, BINARY_MAGIC, 8);
+	header.V = V;
+	header.E = E;
+	header.checksum = checksum(payload.data(), payload.size());
+	FILE *file = fopen(path, "wb");
+	if (!file || fwrite(&header, sizeof(header), 1, file) != 1 ||
+	    fwrite(payload.data(), 1, payload.size(), file) != payload.size() || fclose(file)) {
+		fprintf(stderr, "cannot write %s\n", path);
+		exit(errno);
+	}
+}
+
+void get_input() {
+	// map stdin if it is a file, read it through otherwise
+	struct stat st;
+	const char *data;
+	size_t size;
+	void *mapped = MAP_FAILED;
+	std::vector<char> buffer;
+	if (fstat(0, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0)
+		mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, 0, 0);
+	if (mapped != MAP_FAILED) {
+		data = (const char *)mapped;
+		size = st.st_size;
+	} else {
+		char chunk[1 << 16];
+		ssize_t n;
+		while ((n = read(0, chunk, sizeof(chunk))) > 0)
+			buffer.insert(buffer.end(), chunk, chunk + n);
+		data = buffer.data();
+		size = buffer.size();
+	}
+	if (size >= sizeof(binary_header) && std::memcmp(data, BINARY_MAGIC, 8) == 0)
+		read_binary(data, size);
+	else
+		parse_text(data, data + size);
+	if (mapped != MAP_FAILED)
+		munmap(mapped, st.st_size);
+}
+
+// members of every population for chromosomes of slot bytes: MAX_POPULATION over all islands,
+// fewer if they and the children of every island exceed population_mb
+int population_for(size_t slot) {
+	double fits = population_mb * 1048576.0 / slot - (double)NUM_CHILDREN * num_islands;
+	return std::max(2, (int)std::min((double)MAX_POPULATION, fits) / num_islands);
+}
+
+// what the solver derives from V and the edge list, once reduce() is done with them
+void prepare() {
+	W = (V + 63) / 64;
+	last_mask = ~0ULL >> (W * 64 - V);
+	unit_weights = true;
+	total_weight = 0;
+	weight_c = E ? abs(G.edge_w[0]) : 1;
+	bool sign_weights = true;
+	for (int64_t i = 0; i < E; i++) {
+		if (G.edge_w[i] != 1)
+			unit_weights = false;
+		if (abs(G.edge_w[i]) != weight_c)
+			sign_weights = false;
+		total_weight += G.edge_w[i];
+	}
+	weight_class = unit_weights ? UNIT_WEIGHTS : sign_weights ? SIGN_WEIGHTS : STORED_WEIGHTS;
+	std::vector<int64_t> weighted_degrees(V);
+	for (int64_t i = 0; i < E; i++) {
+		weighted_degrees[G.edge_u[i]] += abs(G.edge_w[i]);
+		weighted_degrees[G.edge_v[i]] += abs(G.edge_w[i]);
+	}
+	// gains are int, they swing between -max_gain and max_gain
+	int64_t largest = V ? *std::max_element(weighted_degrees.begin(), weighted_degrees.end()) : 0;
+	if (largest > INT32_MAX / 2) {
+		fprintf(stderr, "weights around a vertex sum up to %lld, too large\n", (long long)largest);
+		exit(EINVAL);
+	}
+	max_gain = largest;
+	use_buckets = max_gain <= MAX_BUCKETS;
+	// gains are cached if those of the population population_mb leaves room for, children included, fit in gain_cache_mb
+	size_t cached_slot = sizeof(chromosome) + W * sizeof(uint64_t) + V * sizeof(int);
+	double cached_chrs = (double)(population_for((cached_slot + 63) / 64 * 64) + NUM_CHILDREN) * num_islands;
+	cache_gains = cached_chrs * V * sizeof(int) <= gain_cache_mb * 1048576.0;
+
+	random_generator rng(seeder.next());
+	zobrist.resize(V);
+	zobrist_all = 0;
+	for (int i = 0; i < V; i++) {
+		zobrist[i] = (uint64_t)rng.next() << 32 | rng.next();
+		zobrist_all ^= zobrist[i];
+	}
+}
+
+void visit(int u) {
+	visits[u] = 1;
+	renumbers[u] = renumber_cnt;
+	real_numbers[renumber_cnt] = u;
+	renumber_cnt++;
+}
+
+// preorder in the same order as the recursive version, with an explicit stack
+// of (vertex, next neighbour) so deep graphs cannot overflow the call stack
+void dfs(const graph &original, int root) {
+	if (visits[root]) return;
+	std::vector<std::pair<int, int64_t>> stack;
+	visit(root);
+	stack.emplace_back(root, original.offsets[root]);
+	while (!stack.empty()) {
+		int u = stack.back().first;
+		int64_t &next = stack.back().second;
+		if (next == original.offsets[u + 1]) {
+			stack.pop_back();
+			continue;
+		}
+		int v = original.neighbors[next++];
+		if (visits[v]) continue;
+		visit(v);
+		stack.emplace_back(v, original.offsets[v]);
+	}
+}
+
+void find_leftmost();
+
+// vertex order of renumber(), -O. it decides the locality of the gain arrays
+// and which genes stay together under two-point crossover
+SOLVER_STATE enum { DFS_ORDER, RCM_ORDER, GRID_ORDER, SPECTRAL_ORDER } ordering;
+const char *ordering_names[] = {"dfs", "rcm", "grid", "spectral"};
+
+// max-adjacency search from a random vertex, then a preorder over its order of neighbours
+std::vector<int> order_dfs(graph &original) {
+	visits.assign(V, 0);
+	std::vector<int> degrees(V);
+	Q.emplace(0, seeder.next() % V);
+	while (!Q.empty()) {
+		int u = Q.top().second;
+		Q.pop();
+		PROBE(renumber_pops++);
+		if (visits[u]) {
+			PROBE(renumber_stale++);
+			continue;
+		}
+		visits[u] = 1;
+		renumbers[u] = renumber_cnt++;
+		for (int64_t i = original.offsets[u]; i < original.offsets[u + 1]; i++) {
+			int v = original.neighbors[i];
+			if (visits[v]) continue;
+			degrees[v]++;
+			Q.emplace(degrees[v], v);
+		}
+	}
+	original.sort_rows([](int v) { return renumbers[v]; });
+	// vertices the search from one root did not reach are numbered by the dfs below,
+	// which starts from every vertex. reduce() leaves a single component here unless it was skipped
+	std::fill(visits.begin(), visits.end(), 0);
+	renumber_cnt = 0;
+	for (int i = 0; i < V; i++)
+		dfs(original, i);
+	return real_numbers;
+}
+
+// breadth-first levels from root over unmarked vertices: appends them to order and marks them.
+// returns the index in order where the last level starts
+size_t bfs(const graph &g, int root, std::vector<int> &order, std::vector<uint8_t> &marks, std::vector<int> *dist = nullptr) {
+	size_t start = order.size(), last = start;
+	order.push_back(root);
+	marks[root] = 1;
+	if (dist) (*dist)[root] = 0;
+	for (size_t j = start, level_end = start + 1; j < order.size(); j++) {
+		if (j == level_end) {
+			last = j;
+			level_end = order.size();
+		}
+		int u = order[j];
+		for (int64_t i = g.offsets[u]; i < g.offsets[u + 1]; i++) {
+			int v = g.neighbors[i];
+			if (marks[v]) continue;
+			marks[v] = 1;
+			if (dist) (*dist)[v] = (*dist)[u] + 1;
+			order.push_back(v);
+		}
+	}
+	return last;
+}
+
+int degree(const graph &g, int u) {
+	return g.offsets[u + 1] - g.offsets[u];
+}
+
+// reverse Cuthill-McKee: per component, breadth-first from a pseudo-peripheral vertex with
+// neighbours by increasing degree, then the whole order reversed. every edge spans few positions
+std::vector<int> order_rcm(const graph &g) {
+	std::vector<int> order, roots(V), level, dist(V);
+	std::vector<uint8_t> marks(V), scratch(V);
+	for (int u = 0; u < V; u++)
+		roots[u] = u;
+	std::stable_sort(roots.begin(), roots.end(), [&](int a, int b) { return degree(g, a) < degree(g, b); });
+	for (int root : roots) {
+		if (marks[root]) continue;
+		// George and Liu: go on from a vertex of least degree in the last level while the eccentricity grows
+		for (int eccentricity = -1;;) {
+			level.clear();
+			size_t last = bfs(g, root, level, scratch, &dist);
+			for (int v : level)
+				scratch[v] = 0;
+			if (dist[level.back()] <= eccentricity) break;
+			eccentricity = dist[level.back()];
+			for (size_t j = last; j < level.size(); j++)
+				if (j == last || degree(g, level[j]) < degree(g, root))
+					root = level[j];
+		}
+		size_t start = order.size();
+		order.push_back(root);
+		marks[root] = 1;
+		for (size_t j = start; j < order.size(); j++) {
+			int u = order[j];
+			size_t first = order.size();
+			for (int64_t i = g.offsets[u]; i < g.offsets[u + 1]; i++)
+				if (!marks[g.neighbors[i]]) {
+					marks[g.neighbors[i]] = 1;
+					order.push_back(g.neighbors[i]);
+				}
+			std::sort(order.begin() + first, order.end(), [&](int a, int b) { return degree(g, a) < degree(g, b); });
+		}
+	}
+	std::reverse(order.begin(), order.end());
+	return order;
+}
+
+// Gray code curve over pseudo coordinates, for grid-like graphs such as the toroidal instances.
+// the distances to GRID_LANDMARKS far apart vertices stand in for the grid coordinates,
+// vertices are sorted by the rank on the curve of their interleaved coordinate bits
+std::vector<int> order_grid(const graph &g) {
+	std::vector<std::vector<int>> coordinates(GRID_LANDMARKS, std::vector<int>(V));
+	std::vector<int> nearest(V, INT32_MAX), level;
+	std::vector<uint8_t> marks(V);
+	bfs(g, 0, level, marks);
+	int landmark = level.back();  // far from vertex 0
+	int bits = 1;
+	for (int k = 0; k < GRID_LANDMARKS; k++) {
+		std::fill(marks.begin(), marks.end(), 0);
+		level.clear();
+		for (int u = -1; u < V; u++) {
+			int root = u < 0 ? landmark : u;  // other components from their first vertex
+			if (!marks[root])
+				bfs(g, root, level, marks, &coordinates[k]);
+		}
+		for (int u = 0; u < V; u++) {
+			nearest[u] = std::min(nearest[u], coordinates[k][u]);
+			while (bits < 64 / GRID_LANDMARKS && coordinates[k][u] >> bits)
+				bits++;
+		}
+		// the next landmark is the vertex farthest from all so far, once nearest[] is complete
+		landmark = 0;
+		for (int u = 1; u < V; u++)
+			if (nearest[u] > nearest[landmark])
+				landmark = u;
+	}
+	std::vector<std::pair<uint64_t, int>> ranks(V);
+	for (int u = 0; u < V; u++) {
+		uint64_t code = 0;
+		for (int b = bits - 1; b >= 0; b--)
+			for (int k = 0; k < GRID_LANDMARKS; k++)
+				code = code << 1 | (coordinates[k][u] >> b & 1);
+		for (int shift = 1; shift < 64; shift <<= 1)
+			code ^= code >> shift;  // the rank whose Gray code is code
+		ranks[u] = {code, u};
+	}
+	std::sort(ranks.begin(), ranks.end());
+	std::vector<int> order(V);
+	for (int i = 0; i < V; i++)
+		order[i] = ranks[i].second;
+	return order;
+}
+
+// vertices sorted by their entry of the Fiedler vector, found by power iteration on c I - L.
+// c = 2 * largest degree bounds the spectrum of the Laplacian L, and the constant vector
+// is projected out every step, so the iteration goes to L's second smallest eigenvector
+std::vector<int> order_spectral(const graph &g) {
+	std::vector<double> x(V), y(V);
+	random_generator rng(seeder.next());
+	int c = 1;
+	for (int u = 0; u < V; u++) {
+		x[u] = rng.next() / 4294967296.0 - 0.5;
+		c = std::max(c, 2 * degree(g, u));
+	}
+	for (int it = 0; it < SPECTRAL_ITERATIONS; it++) {
+		double mean = 0, norm = 0;
+		for (int u = 0; u < V; u++) {
+			double sum = (c - degree(g, u)) * x[u];
+			for (int64_t i = g.offsets[u]; i < g.offsets[u + 1]; i++)
+				sum += x[g.neighbors[i]];
+			y[u] = sum;
+			mean += sum;
+		}
+		mean /= V;
+		for (int u = 0; u < V; u++) {
+			y[u] -= mean;
+			norm += y[u] * y[u];
+		}
+		if (norm == 0) break;
+		norm = std::sqrt(norm);
+		for (int u = 0; u < V; u++)
+			x[u] = y[u] / norm;
+	}
+	std::vector<int> order(V);
+	for (int u = 0; u < V; u++)
+		order[u] = u;
+	std::stable_sort(order.begin(), order.end(), [&](int a, int b) { return x[a] < x[b]; });
+	return order;
+}
+
+void renumber() {
+	// adjacency in input numbering, only to find the order
+	graph original = G;
+	original.build_adjacency();
+	renumbers.resize(V);
+	real_numbers.resize(V);
+	std::vector<int> order;
+	switch (ordering) {
+	case DFS_ORDER:
+		order = order_dfs(original);
+		break;
+	case RCM_ORDER:
+		order = order_rcm(original);
+		break;
+	case GRID_ORDER:
+		order = order_grid(original);
+		break;
+	case SPECTRAL_ORDER:
+		order = order_spectral(original);
+		break;
+	}
+	for (int i = 0; i < V; i++) {
+		real_numbers[i] = order[i];
+		renumbers[order[i]] = i;
+	}
+
+	std::vector<std::tuple<int, int, int>> sorted_edges(E);
+	for (int64_t i = 0; i < E; i++) {
+		int u = renumbers[G.edge_u[i]], v = renumbers[G.edge_v[i]];
+		sorted_edges[i] = std::make_tuple(std::min(u, v), std::max(u, v), G.edge_w[i]);
+	}
+	std::sort(sorted_edges.begin(), sorted_edges.end());
+	for (int64_t i = 0; i < E; i++)
+		std::tie(G.edge_u[i], G.edge_v[i], G.edge_w[i]) = sorted_edges[i];
+	G.build_adjacency();
+	G.sort_rows([](int v) { return v; });
+	find_leftmost();
+	// how far apart the ends of an edge are on average, the locality the order achieved
+	double span = 0;
+	for (int64_t i = 0; i < E; i++)
+		span += G.edge_v[i] - G.edge_u[i];
+	if (!quiet)
+		fprintf(stderr, "ordering: %s, mean edge span %.1lf\n", ordering_names[ordering], E ? span / E : 0.0);
+}
+
+void find_leftmost() {
+	// leftmost[i] = min(i, smallest u having a neighbour v >= i)
+	leftmost.resize(V + 1);
+	leftmost[V] = V;
+	for (int i = V - 1; i >= 0; i--) {
+		leftmost[i] = std::min(leftmost[i + 1], i);
+		if (G.offsets[i] < G.offsets[i + 1])
+			leftmost[i] = std::min(leftmost[i], G.neighbors[G.offsets[i]]);
+	}
+}
+
+SOLVER_STATE int num_threads = NUM_THREADS;
+SOLVER_STATE std::vector<workspace> workspaces;
+SOLVER_STATE double time_limit = -1;  // seconds since starts_at, V / 6 - SPARE_TIME unless -t is given
+SOLVER_STATE int64_t target_score = INT64_MAX;  // -o: every population stops once one reaches it
+SOLVER_STATE int stall_limit;  // -x: a population stops after this many generations without improvement, 0 never
+SOLVER_STATE int restart_interval;  // -R: a population restarts after this many generations without improvement, 0 never
+SOLVER_STATE std::atomic<bool> target_reached;  // by any population, or by another worker of the coordinator
+SOLVER_STATE std::atomic<long long> restarts;
+SOLVER_STATE bool print_stats;  // -S: improvements of the best and throughput counters on stderr
+SOLVER_STATE int migration_interval = MIGRATION_INTERVAL;
+SOLVER_STATE int num_migrants = NUM_MIGRANTS;
+SOLVER_STATE bool random_topology;  // -T random: migrants go to a random other island instead of the next on the ring
+SOLVER_STATE int num_processes;  // -N: worker processes under this one as coordinator, 0 runs the GA here
+SOLVER_STATE const char *listen_path;  // -L: the coordinator waits for -N workers on this socket instead of forking them
+SOLVER_STATE const char *worker_path;  // -W: run as a worker of the coordinator listening on this socket
+
+// counters of the finished run, printed by -S and sent to the coordinator
+class run_stats {
+public:
+	long long generations = 0, children = 0, local_opts = 0, restarts = 0;
+	double init = 0, loop = 0;
+};
+SOLVER_STATE run_stats stats;
+
+// what the instance will cost at this V and E, printed before the population is built
+void report_memory() {
+	size_t cells = 1;  // hash_set::init()
+	while (cells < 2 * (size_t)(population_size + NUM_CHILDREN))
+		cells <<= 1;
+	double graph = (2 * E + G.edge_w.size() + 2 * E + G.weights.size() + 2 * V + 1) * sizeof(int)
+	               + (V + 1 + G.signs.size() + G.edge_signs.size()) * sizeof(uint64_t)
+	               + V * sizeof(uint64_t);  // edges, adjacency, maps, leftmost, offsets and signs, zobrist
+	double chromosomes = (double)(population_size + NUM_CHILDREN) * num_islands * pool.slot_size;
+	double index = ((double)population_size * (sizeof(evaluation) + sizeof(chromosome *))
+	                + NUM_CHILDREN * (sizeof(chromosome *) + sizeof(uint64_t)) + cells * sizeof(uint64_t)) * num_islands;
+	int max_key = local_search == TABU_SEARCH ? 2 * max_gain + 1 : max_gain;
+	double scratch = (double)num_threads * (V * ((use_buckets ? 5 : 3) + (local_search == TABU_SEARCH ? 2 : 0)) * sizeof(int)
+	                                        + (use_buckets ? max_key + 1 : 0) * sizeof(int));
+	fprintf(stderr, "memory: V %d, E %lld, graph %.1lf MB, %d + %d chromosomes of %zu bytes %.1lf MB, "
+	        "population index %.1lf MB, workspaces %.1lf MB\n",
+	        V, (long long)E, graph / 1048576, population_size * num_islands, NUM_CHILDREN * num_islands, pool.slot_size,
+	        chromosomes / 1048576, index / 1048576, scratch / 1048576);
+}
+
+// children are handed out in chunks, so workers finishing early steal the rest
+SOLVER_STATE std::atomic<int> next_child;
+SOLVER_STATE std::mutex pool_mutex;
+SOLVER_STATE std::condition_variable pool_wakeup, pool_done;
+SOLVER_STATE int pool_generation, pool_pending;
+SOLVER_STATE bool pool_stop;
+
+template <class weight>
+chromosome *make_child(population &pop, workspace &ws) {
+	int x = ws.rng(pop.num_chrs);
+	int y = ws.rng(pop.num_chrs);
+	ws.children++;
+	return pop.chrs[x]->crossover<weight>(pop.chrs[y], ws)  // always create new chromosome
+	                 ->template mutation<weight>(false, ws)  // create new chromosome when flag is given
+	                 ->template local_opt<weight>(ws);  // do not create new chromosome
+}
+
+// make_child() for the weight class of the input, set by compact_weights()
+SOLVER_STATE chromosome *(*child_maker)(population &pop, workspace &ws) = make_child<stored_weight>;
+
+// once the adjacency is final: sign bits instead of weights for +-c graphs, nothing for unit weights,
+// and the solver instantiated for the class
+void compact_weights() {
+	if (weight_class == SIGN_WEIGHTS) {
+		G.signs.assign((2 * E + 63) / 64, 0);
+		for (int64_t i = 0; i < 2 * E; i++)
+			if (G.weights[i] < 0)
+				G.signs[i >> 6] |= 1ULL << (i & 63);
+		G.edge_signs.assign((E + 63) / 64, 0);
+		for (int64_t i = 0; i < E; i++)
+			if (G.edge_w[i] < 0)
+				G.edge_signs[i >> 6] |= 1ULL << (i & 63);
+	}
+	if (weight_class != STORED_WEIGHTS) {
+		std::vector<int>().swap(G.weights);
+		std::vector<int>().swap(G.edge_w);
+	}
+	// per weight_class, like the kernels
+	chromosome *(*const child_makers[NUM_WEIGHT_CLASSES])(population &pop, workspace &ws) = {
+		make_child<unit_weight>, make_child<sign_weight>, make_child<stored_weight>};
+	child_maker = child_makers[weight_class];
+	if (!quiet)
+		fprintf(stderr, "weights: %s\n", weight_class_names[weight_class]);
+}
+
+void make_children(workspace &ws) {
+	PHASE(ws.probe.busy);
+	int i;
+	while ((i = next_child.fetch_add(CHILDREN_CHUNK)) < NUM_CHILDREN) {
+		int end = std::min(i + CHILDREN_CHUNK, NUM_CHILDREN);
+		for (; i < end; i++)
+			group.children[i] = child_maker(group, ws);
+	}
+}
+
+void worker(int id) {
+	if (profile)
+		workspaces[id].perf.open();  // counts this thread only, a failure leaves its events out
+	int seen = 0;
+	while (true) {
+		{
+			std::unique_lock<std::mutex> lock(pool_mutex);
+			pool_wakeup.wait(lock, [&] { return pool_stop || pool_generation != seen; });
+			if (pool_stop) return;
+			seen = pool_generation;
+		}
+		make_children(workspaces[id]);
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		if (--pool_pending == 0)
+			pool_done.notify_one();
+	}
+}
+
+// fills group.children[], the population itself is read-only meanwhile
+void generate_children() {
+	next_child = 0;
+	if (num_threads == 1) {
+		make_children(workspaces[0]);
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		pool_pending = num_threads - 1;
+		pool_generation++;
+	}
+	pool_wakeup.notify_all();
+	make_children(workspaces[0]);
+	std::unique_lock<std::mutex> lock(pool_mutex);
+	pool_done.wait(lock, [] { return pool_pending == 0; });
+}
+
+// one line per phase summed over the threads, n/a for events this machine cannot count
+void print_perf() {
+	double totals[NUM_PERF_PHASES][NUM_PERF_EVENTS] = {};
+	for (auto &ws : workspaces)
+		ws.perf.add_to(totals);
+	for (int p = 0; p < NUM_PERF_PHASES; p++) {
+		fprintf(stderr, "perf phase=%s", perf_phase_names[p]);
+		for (int e = 0; e < NUM_PERF_EVENTS; e++)
+			if (totals[p][e] < 0)
+				fprintf(stderr, " %s=n/a", perf_event_names[e]);
+			else
+				fprintf(stderr, " %s=%.0lf", perf_event_names[e], totals[p][e]);
+		fprintf(stderr, "\n");
+	}
+}
+
+// a byte stream to one peer. unix_transport is the only backend so far,
+// a TCP one only has to provide the same calls on a connected socket
+class transport {
+public:
+	virtual ~transport() = default;
+	virtual bool send(const void *data, size_t size) = 0;  // false if the peer is gone
+	virtual bool receive(void *data, size_t size) = 0;  // false if the peer is gone
+	virtual int fd() const = 0;  // for poll() in the coordinator
+};
+
+class unix_transport : public transport {
+public:
+	int sock;
+
+	unix_transport(int sock_) : sock(sock_) {}
+
+	~unix_transport() {
+		close(sock);
+	}
+
+	bool send(const void *data, size_t size) override {
+		const char *p = (const char *)data;
+		while (size) {
+			ssize_t n = ::send(sock, p, size, MSG_NOSIGNAL);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) return false;
+			p += n;
+			size -= n;
+		}
+		return true;
+	}
+
+	bool receive(void *data, size_t size) override {
+		char *p = (char *)data;
+		while (size) {
+			ssize_t n = read(sock, p, size);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) return false;
+			p += n;
+			size -= n;
+		}
+		return true;
+	}
+
+	int fd() const override {
+		return sock;
+	}
+
+	static sockaddr_un address(const char *path) {
+		sockaddr_un addr;
+		std::memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (strlen(path) >= sizeof(addr.sun_path)) exit(ENAMETOOLONG);
+		strcpy(addr.sun_path, path);
+		return addr;
+	}
+
+	static std::unique_ptr<transport> connect_to(const char *path) {
+		sockaddr_un addr = address(path);
+		int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (sock < 0 || connect(sock, (sockaddr *)&addr, sizeof(addr))) exit(errno);
+		return std::unique_ptr<transport>(new unix_transport(sock));
+	}
+
+	static std::vector<std::unique_ptr<transport>> accept_from(const char *path, int n) {
+		sockaddr_un addr = address(path);
+		int server = socket(AF_UNIX, SOCK_STREAM, 0);
+		unlink(path);
+		if (server < 0 || bind(server, (sockaddr *)&addr, sizeof(addr)) || listen(server, n)) exit(errno);
+		std::vector<std::unique_ptr<transport>> peers;
+		while ((int)peers.size() < n) {
+			int sock = accept(server, nullptr, nullptr);
+			if (sock < 0 && errno == EINTR) continue;
+			if (sock < 0) exit(errno);
+			peers.emplace_back(new unix_transport(sock));
+		}
+		close(server);
+		unlink(path);
+		return peers;
+	}
+};
+
+// a message is a header and count records, all in 64-bit words
+enum { MSG_MIGRANTS, MSG_BEST, MSG_DONE };
+
+struct message_header {
+	uint32_t type, count;
+	uint64_t words;
+};
+
+bool send_message(transport &t, uint32_t type, uint32_t count, const std::vector<uint64_t> &payload) {
+	message_header h = {type, count, payload.size()};
+	return t.send(&h, sizeof(h)) && t.send(payload.data(), payload.size() * sizeof(uint64_t));
+}
+
+bool receive_message(transport &t, message_header &h, std::vector<uint64_t> &payload) {
+	if (!t.receive(&h, sizeof(h))) return false;
+	payload.resize(h.words);
+	return t.receive(payload.data(), h.words * sizeof(uint64_t));
+}
+
+// a chromosome between processes is its score, a hash and its genes by input vertex,
+// processes may have renumbered the graph differently
+int wire_words() {
+	return 2 + W;
+}
+
+// equal for a partition and its complement, like chromosome::hash()
+uint64_t wire_hash(const uint64_t *genes) {
+	uint64_t flip = (genes[0] & 1) ? ~0ULL : 0, h = 0;
+	for (int i = 0; i < W; i++) {
+		h = (h ^ ((genes[i] ^ flip) & (i == W - 1 ? last_mask : ~0ULL))) * 0x9E3779B97F4A7C15ULL;
+		h ^= h >> 29;
+	}
+	return h;
+}
+
+void pack(chromosome *chr, uint64_t *out) {
+	uint64_t *genes = out + 2;
+	std::memset(genes, 0, W * sizeof(uint64_t));
+	for (int i = 0; i < V; i++)
+		if (chr->get(i))
+			genes[real_numbers[i] >> 6] |= 1ULL << (real_numbers[i] & 63);
+	out[0] = chr->score;
+	out[1] = wire_hash(genes);
+}
+
+// the score is computed again on evaluation, gains are only known after that
+chromosome *unpack(const uint64_t *in) {
+	const uint64_t *genes = in + 2;
+	chromosome *chr = new chromosome();
+	for (int v = 0; v < V; v++)
+		if (genes[v >> 6] >> (v & 63) & 1)
+			chr->flip(renumbers[v]);
+	return chr;
+}
+
+SOLVER_STATE std::unique_ptr<transport> remote;  // the coordinator, if this process is one of its workers
+SOLVER_STATE std::mutex remote_mutex;
+SOLVER_STATE bool remote_lost;  // the coordinator went away, the run goes on alone
 
-double starts_at;
+// sends the best num_migrants to the coordinator and takes in what it forwarded from another worker.
+// the coordinator answers every batch at once, so this never waits on another worker
+void exchange_remote(population &pop) {
+	std::vector<chromosome *> migrants = pop.best(num_migrants);
+	int n = migrants.size();
+	std::vector<uint64_t> payload(n * wire_words());
+	for (int i = 0; i < n; i++)
+		pack(migrants[i], &payload[i * wire_words()]);
+	message_header h;
+	{
+		std::lock_guard<std::mutex> lock(remote_mutex);
+		if (remote_lost) return;
+		if (!send_message(*remote, MSG_MIGRANTS, n, payload) || !receive_message(*remote, h, payload)) {
+			fprintf(stderr, "lost the coordinator, running alone\n");
+			remote_lost = true;
+			return;
+		}
+	}
+	if (h.type == MSG_DONE) {  // another worker reached the target
+		target_reached = true;
+		return;
+	}
+	int count = std::min<int>(h.count, std::min<uint64_t>(NUM_CHILDREN, payload.size() / wire_words()));
+	for (int i = 0; i < count; i++)
+		pop.children[i] = unpack(&payload[i * wire_words()]);
+	pop.replace(count);
+}
 
-int V, E;
-int edges[MAX_E][3];
-std::vector<int> vertices[MAX_V];
-std::vector<std::pair<int, int>> infos[MAX_V];
-std::priority_queue<std::pair<int, int>> Q;
+void send_best(int64_t score) {
+	std::lock_guard<std::mutex> lock(remote_mutex);
+	if (!remote_lost)
+		send_message(*remote, MSG_BEST, 1, {(uint64_t)score});
+}
 
-int hash_const;  // (2^V - 1) % MOD
-int renumber_cnt;
-uint8_t visits[MAX_V];
-int degrees[MAX_V], renumbers[MAX_V], real_numbers[MAX_V];
+// the final best and the counters of this worker, the last message it sends
+void finish_remote(chromosome *best) {
+	std::vector<uint64_t> payload(6 + wire_words());
+	payload[0] = stats.generations;
+	payload[1] = stats.children;
+	payload[2] = stats.local_opts;
+	std::memcpy(&payload[3], &stats.init, sizeof(double));
+	std::memcpy(&payload[4], &stats.loop, sizeof(double));
+	payload[5] = stats.restarts;
+	pack(best, &payload[6]);
+	std::lock_guard<std::mutex> lock(remote_mutex);
+	if (!remote_lost)
+		send_message(*remote, MSG_DONE, 1, payload);
+}
 
-int get_complement(int hash) {
-	int complement = hash_const - hash;
-	if (complement < 0) complement += MOD;
-	return complement;
+void print_run_stats() {
+	fprintf(stderr, "stats generations=%lld children=%lld local_opts=%lld restarts=%lld init=%lf loop=%lf\n",
+	        stats.generations, stats.children, stats.local_opts, stats.restarts, stats.init, stats.loop);
 }
 
-double get_time() {
-	struct timespec ts;
-	// get wall-clock time
-	if (clock_gettime(CLOCK_REALTIME, &ts)) exit(errno);
-	return ts.tv_sec + ts.tv_nsec * 1e-9;
+// -S prints every improvement of the best over all populations
+SOLVER_STATE std::mutex best_mutex;
+SOLVER_STATE int64_t best_score = INT64_MIN;
+
+void publish_best(int64_t score) {
+	std::lock_guard<std::mutex> lock(best_mutex);
+	if (score <= best_score) return;
+	best_score = score;
+	if (score >= target_score)
+		target_reached = true;
+	if (print_stats)
+		fprintf(stderr, "best %lf %lld\n", get_time() - starts_at, (long long)(score + reduced.offset));
+	if (remote)
+		send_best(score);
 }
 
-class chromosome {
+// islands send copies of their best through a one-slot mailbox per island.
+// a sender swaps its batch in and frees whatever was not picked up yet,
+// so a slow island only ever gets the newest migrants
+class mailbox {
 public:
-	uint8_t genes[MAX_V];
-	int score = INT32_MAX;
-
-	chromosome(bool initialize = false) {
-		if (initialize)
-			for (int i = 0; i < V; i += 31) {
-				int rand_num = rand();  // 31-bits
-				int end = std::max(i + 31, V);
-				for (int j = i; j < end; j++) {
-					genes[j] = rand_num % 2;
-					rand_num >>= 1;
-				}
-			}
-	}
+	alignas(64) std::atomic<std::vector<chromosome *> *> migrants{nullptr};
+};
 
-	chromosome(chromosome *other) {
-		std::memcpy(genes, other->genes, V * sizeof(uint8_t));
-	}
+SOLVER_STATE std::vector<population> islands;
+SOLVER_STATE std::unique_ptr<mailbox[]> mailboxes;
 
-	void get_interval(chromosome *other, int left, int right, bool flip) {
-		std::memcpy(genes + left, other->genes + left, (right - left) * sizeof(uint8_t));
-		if (flip)
-			for (int i = left; i < right; i++)
-				genes[i] = 1 - genes[i];
-	}
+void release_migrants(std::vector<chromosome *> *migrants) {
+	if (!migrants) return;
+	for (chromosome *chr : *migrants)
+		delete chr;
+	delete migrants;
+}
 
-	chromosome *crossover(chromosome *other) {
-		int cp[CUTTING_POINT + 2];
-		cp[0] = 0;
-		cp[CUTTING_POINT + 1] = V;
-		for (int i = 1; i <= CUTTING_POINT; i++)
-			cp[i] = rand() % V;
-		// std::sort(cp + 1, cp + CUTTING_POINT + 1);
-		if (cp[1] > cp[2]) {
-			int temp = cp[1];
-			cp[1] = cp[2];
-			cp[2] = temp;
+// every migration_interval generations the best num_migrants go to the next island on the ring,
+// or to a random other one, and whatever arrived meanwhile is taken in like children
+void migrate(population &pop, int id, int generation) {
+	workspace &ws = workspaces[id];
+	if (generation % migration_interval == 0) {
+		auto *out = new std::vector<chromosome *>;
+		for (chromosome *chr : pop.best(num_migrants)) {
+			chromosome *copy = new chromosome(chr);
+			copy->score = chr->score;
+			out->push_back(copy);
 		}
-		// create empty chromosome and copy intervals from this and others
-		chromosome *child = new chromosome();
-		bool flip = rand() % 2;
-		for (int i = 0; i <= CUTTING_POINT; i++)
-			child->get_interval((i % 2) ? other : this, cp[i], cp[i + 1], (i % 2) && flip);
-		return child;
+		int to = random_topology ? (id + 1 + ws.rng(num_islands - 1)) % num_islands : (id + 1) % num_islands;
+		release_migrants(mailboxes[to].migrants.exchange(out, std::memory_order_acq_rel));
+	}
+	auto *in = mailboxes[id].migrants.exchange(nullptr, std::memory_order_acq_rel);
+	if (in) {
+		std::copy(in->begin(), in->end(), pop.children.begin());
+		pop.replace(in->size());
+		delete in;
 	}
+}
 
-	chromosome *mutation(bool create) {
-		int idx = rand() % V;
-		if (create) {
-			chromosome *child = new chromosome(this);
-			child->genes[idx] = 1 - child->genes[idx];
-			return child;
-		} else {
-			genes[idx] = 1 - genes[idx];
-			return this;
-		}
+#ifdef TELEMETRY
+// mean distance of sampled pairs over V, a chromosome and its complement are at distance 0
+double diversity(population &pop, random_generator &rng) {
+	if (pop.num_chrs < 2) return 0;
+	double sum = 0;
+	for (int k = 0; k < DIVERSITY_PAIRS; k++) {
+		chromosome *a = pop.chrs[rng(pop.num_chrs)], *b = pop.chrs[rng(pop.num_chrs)];
+		int d = 0;
+		for (int i = 0; i < W; i++)
+			d += __builtin_popcountll(a->genes[i] ^ b->genes[i]);
+		sum += std::min(d, V - d);
 	}
+	return sum / DIVERSITY_PAIRS / V;
+}
 
-	chromosome *local_opt() {
-		std::memset(degrees, 0, V * sizeof(int));
-		score = 0;
-		for (int i = 0; i < E; i++) {
-			if (genes[edges[i][0]] != genes[edges[i][1]]) {
-				score += edges[i][2];
-				degrees[edges[i][0]] -= edges[i][2];
-				degrees[edges[i][1]] -= edges[i][2];
-			} else {
-				degrees[edges[i][0]] += edges[i][2];
-				degrees[edges[i][1]] += edges[i][2];
-			}
-		}
-		int before = score;
-		for (int i = 0; i < V; i++)
-			if (degrees[i] > 0)
-				Q.emplace(degrees[i], i);
-		// int cnt = 0;
-		while (!Q.empty()) {
-		// while (!Q.empty() && cnt < NUM_LOCAL_OPT) {
-			auto [diff, u] = Q.top();
-			Q.pop();
-			if (diff != degrees[u])
-				continue;
-			// cnt++;
-			score += diff;
-			for (auto [v, w] : infos[u]) {
-				if (genes[u] != genes[v]) {
-					degrees[u] += 2 * w;
-					degrees[v] += 2 * w;
-				} else {
-					degrees[u] -= 2 * w;
-					degrees[v] -= 2 * w;
-				}
-				if (degrees[v] > 0)
-					Q.emplace(degrees[v], v);
-			}
-			genes[u] = 1 - genes[u];
-			if (degrees[u] > 0)
-				Q.emplace(degrees[u], u);
-		}
-		return this;
+void print_histogram(const char *name, const histogram &h) {
+	int n = TELEMETRY_BINS;
+	while (n > 1 && h.bins[n - 1] == 0)
+		n--;
+	fprintf(stderr, ", \"%s\": [", name);
+	for (int i = 0; i < n; i++)
+		fprintf(stderr, "%s%lld", i ? ", " : "", h.bins[i]);
+	fprintf(stderr, "]");
+}
+
+// one JSON line of running totals of pop and the n workspaces making its children,
+// consecutive lines can be subtracted for rates
+void print_telemetry(population &pop, workspace *wss, int n, int island, int generation, random_generator &rng) {
+	probes sum;
+	long long children = 0;
+	for (workspace *ws = wss; ws < wss + n; ws++) {
+		sum.crossover += ws->probe.crossover;
+		sum.mutation += ws->probe.mutation;
+		sum.local_opt += ws->probe.local_opt;
+		sum.busy += ws->probe.busy;
+		sum.updates += ws->probe.updates;
+		sum.noops += ws->probe.noops;
+		sum.flips += ws->probe.flips;
+		sum.queue_updates += ws->probe.queue_updates;
+		children += ws->children;
 	}
+	const population_probes &m = pop.probe;
+	fprintf(stderr, "{\"t\": %.3lf, \"island\": %d, \"generation\": %d, \"best\": %lld, \"population\": %d, "
+	        "\"children\": %lld, \"duplicates\": %lld, \"accepted\": %lld, \"diversity\": %.4lf",
+	        get_time() - starts_at, island, generation, (long long)pop.top.score, pop.num_chrs,
+	        children, m.duplicates, m.accepted, diversity(pop, rng));
+	fprintf(stderr, ", \"seconds\": {\"generate\": %.3lf, \"idle\": %.3lf, \"crossover\": %.3lf, "
+	        "\"mutation\": %.3lf, \"local_opt\": %.3lf, \"replace\": %.3lf, \"insert\": %.3lf, "
+	        "\"release\": %.3lf}",
+	        m.generate * 1e-9, (m.generate * (double)n - sum.busy) * 1e-9, sum.crossover * 1e-9,
+	        sum.mutation * 1e-9, sum.local_opt * 1e-9, m.replace * 1e-9, m.insert * 1e-9, m.release * 1e-9);
+	// the gain queues are indexed, an entry is moved when its gain changes and never goes stale,
+	// only the lazy Q of renumber() has stale entries to count
+	fprintf(stderr, ", \"queue_updates\": %lld, \"noop_ratio\": %.4lf, \"renumber_stale_ratio\": %.4lf",
+	        sum.updates, sum.updates ? (double)sum.noops / sum.updates : 0.0,
+	        renumber_pops ? (double)renumber_stale / renumber_pops : 0.0);
+	print_histogram("flips", sum.flips);
+	print_histogram("updates", sum.queue_updates);
+	fprintf(stderr, "}\n");
+}
+#endif
 
-	int hash() const {
-		int result = 0;
-		for (int i = 0; i < V; i++)
-			result = ((result << 1) | genes[i]) % MOD;
-		return std::min(result, get_complement(result));
+SOLVER_STATE const char *checkpoint_path;  // -c: the populations are saved here every checkpoint_interval seconds and at the end
+SOLVER_STATE const char *restore_path;  // -r: start from this checkpoint instead of random populations
+SOLVER_STATE double checkpoint_interval = CHECKPOINT_INTERVAL;
+
+// checkpoint: binary_header with CHECKPOINT_MAGIC, then 64-bit words: the number of populations,
+// real_numbers[V], zobrist[V], and per population num_chrs, the number of random generators making
+// its children, their states, and score, hash and genes[W] of every member in heap order.
+// genes are in the order of real_numbers, a restore maps them if its own renumbering differs.
+// cached gains are left out, they would make the file 32 times larger, a restore computes them again
+SOLVER_STATE std::mutex checkpoint_mutex;
+SOLVER_STATE std::vector<std::vector<uint64_t>> snapshots;  // the last saved state of every population
+
+// pop and the random generators of the n workspaces making its children, between two generations
+void snapshot(population &pop, workspace *wss, int n, std::vector<uint64_t> &out) {
+	out.clear();
+	out.push_back(pop.num_chrs);
+	out.push_back(n);
+	for (int i = 0; i < n; i++)
+		out.push_back(wss[i].rng.state);
+	for (int i = 0; i < pop.num_chrs; i++) {
+		out.push_back(pop.evals[i].score);
+		out.push_back(pop.evals[i].hash);
+		out.insert(out.end(), pop.evals[i].chr->genes, pop.evals[i].chr->genes + W);
 	}
+}
 
-	int evaluate() {
-		if (score == INT32_MAX) {
-			score = 0;
-			for (int i = 0; i < E; i++)
-				if (genes[edges[i][0]] != genes[edges[i][1]])
-					score += edges[i][2];
-		}
-		return score;
+// the snapshots of all populations, once each has one. written to a temporary file and renamed,
+// so a run killed meanwhile leaves the previous checkpoint
+void write_checkpoint() {
+	std::vector<uint64_t> payload;
+	{
+		std::lock_guard<std::mutex> lock(checkpoint_mutex);
+		for (auto &s : snapshots)
+			if (s.empty()) return;
+		payload.push_back(snapshots.size());
+		payload.insert(payload.end(), real_numbers.begin(), real_numbers.end());
+		payload.insert(payload.end(), zobrist.begin(), zobrist.end());
+		for (auto &s : snapshots)
+			payload.insert(payload.end(), s.begin(), s.end());
 	}
-};
+	binary_header header;
+	std::memcpy(header.magic, CHECKPOINT_MAGIC, 8);
+	header.V = V;
+	header.E = E;
+	header.checksum = checksum((const char *)payload.data(), payload.size() * sizeof(uint64_t));
+	std::string temp = std::string(checkpoint_path) + ".tmp";
+	FILE *file = fopen(temp.c_str(), "wb");
+	bool ok = file && fwrite(&header, sizeof(header), 1, file) == 1 &&
+	          fwrite(payload.data(), sizeof(uint64_t), payload.size(), file) == payload.size() &&
+	          fflush(file) == 0 && fsync(fileno(file)) == 0;
+	if (file && fclose(file)) ok = false;
+	if (!ok || rename(temp.c_str(), checkpoint_path))
+		fprintf(stderr, "cannot write %s\n", checkpoint_path);  // the run goes on without it
+}
 
-class evaluation {
-public:
-	int score;
-	int hash;
-	chromosome *chr;
+// island id, or the only population, saves its state, island 0 writes the file
+void save_population(population &pop, int id) {
+	bool shared = num_islands == 1;
+	{
+		std::lock_guard<std::mutex> lock(checkpoint_mutex);
+		snapshot(pop, shared ? workspaces.data() : &workspaces[id], shared ? num_threads : 1, snapshots[id]);
+	}
+	if (id == 0)
+		write_checkpoint();
+}
 
-	evaluation() = default;
-	evaluation(chromosome *chr_) : chr(chr_) {
-		score = chr->evaluate();
-		hash = chr->hash();
+// one population per island from restore_path instead of random ones, no local_opt() and,
+// without cached gains, no evaluation. the random generators go on where they were
+// if there are as many workspaces as before
+void restore_checkpoint() {
+	FILE *file = fopen(restore_path, "rb");
+	if (!file) exit(errno);
+	binary_header header = {};
+	std::vector<uint64_t> words;
+	struct stat st;
+	if (fstat(fileno(file), &st) == 0 && st.st_size >= (off_t)sizeof(header) &&
+	    fread(&header, sizeof(header), 1, file) == 1) {
+		words.resize((st.st_size - sizeof(header)) / sizeof(uint64_t));
+		words.resize(fread(words.data(), sizeof(uint64_t), words.size(), file));
+	}
+	fclose(file);
+	const uint64_t *p = words.data(), *end = p + words.size();
+	auto need = [&](uint64_t n) {
+		if (n > (uint64_t)(end - p)) {
+			fprintf(stderr, "corrupted checkpoint %s\n", restore_path);
+			exit(EINVAL);
+		}
+	};
+	if (memcmp(header.magic, CHECKPOINT_MAGIC, 8) || header.V != V || header.E != E ||
+	    checksum((const char *)p, words.size() * sizeof(uint64_t)) != header.checksum)
+		need(UINT64_MAX);
+	need(1 + 2 * (uint64_t)V);
+	if ((int)*p != num_islands) {
+		fprintf(stderr, "checkpoint %s has %d populations, not %d\n", restore_path, (int)*p, num_islands);
+		exit(EINVAL);
 	}
+	uint64_t member_words = 2 + W;
+	p++;
+	// position in the checkpoint to position here
+	std::vector<int> map(V);
+	bool same = true;
+	for (int i = 0; i < V; i++) {
+		if (p[i] >= (uint64_t)V) need(UINT64_MAX);
+		map[i] = renumbers[p[i]];
+		same &= map[i] == i;
+	}
+	p += V;
+	// the same keys as before keep the saved hashes valid
+	if (same) {
+		zobrist.assign(p, p + V);
+		zobrist_all = 0;
+		for (int i = 0; i < V; i++)
+			zobrist_all ^= zobrist[i];
+	}
+	p += V;
 
-	bool operator<(const evaluation &other) {
-		return score > other.score ||
-		       (score == other.score && hash < other.hash);
+	std::vector<const uint64_t *> members;  // score, hash and genes of each in the checkpoint
+	std::vector<std::pair<int, int>> ranges;  // members of each population in all
+	for (int k = 0; k < num_islands; k++) {
+		need(2);
+		uint64_t m = p[0], n = p[1];
+		p += 2;
+		if (m == 0) need(UINT64_MAX);  // a population has members, the heap needs a top
+		need(n);
+		bool shared = num_islands == 1;
+		if (n == (uint64_t)(shared ? num_threads : 1))
+			for (uint64_t i = 0; i < n; i++)
+				workspaces[shared ? i : k].rng.state = p[i];
+		p += n;
+		need(m * member_words);
+		ranges.emplace_back(members.size(), members.size() + m);
+		for (uint64_t i = 0; i < m; i++, p += member_words)
+			members.push_back(p);
 	}
-};
 
-class population {
-public:
-	int num_chrs;
-	chromosome *chrs[MAX_POPULATION], *children[NUM_CHILDREN];
-	evaluation evals[MAX_POPULATION + NUM_CHILDREN], temp[MAX_POPULATION + NUM_CHILDREN];
-
-	population() {
-		for (int i = 0; i < MAX_POPULATION; i++) {
-			chrs[i] = new chromosome(true);
-			evals[i] = evaluation(chrs[i]);
-		}
-		std::sort(evals, evals + MAX_POPULATION);
-		num_chrs = 1;
-		for (int i = 1; i < MAX_POPULATION; i++) {
-			if (evals[i].score == evals[i - 1].score &&
-			    evals[i].hash == evals[i - 1].hash)
-				delete evals[i].chr;
-			else
-				evals[num_chrs++] = evals[i];
+	// the members are rebuilt on all threads, this one included, with the O(E) gains scan
+	// of a cold start if gains are cached
+	std::vector<chromosome *> all(members.size());
+	auto rebuild = [&](int t) {
+		for (size_t i = t; i < members.size(); i += num_threads) {
+			const uint64_t *q = members[i], *genes = q + 2;
+			chromosome *chr = all[i] = new chromosome();
+			if (same) {
+				// hash() undone, the key is not summed up again
+				std::memcpy(chr->genes, genes, W * sizeof(uint64_t));
+				chr->key = (genes[0] & 1) ? q[1] ^ zobrist_all : q[1];
+			} else {
+				for (int v = 0; v < V; v++)
+					if (genes[v >> 6] >> (v & 63) & 1)
+						chr->flip(map[v]);
+			}
+			if (cache_gains)
+				chr->init_gains(chr->gains());
+			chr->score = q[0];
 		}
-		for (int i = 0; i < num_chrs; i++)
-			chrs[i] = evals[i].chr;
-	}
+	};
+	std::vector<std::thread> threads;
+	for (int t = 1; t < num_threads; t++)
+		threads.emplace_back(rebuild, t);
+	rebuild(0);
+	for (auto &t : threads)
+		t.join();
 
-	void replace() {
-		for (int i = 0; i < NUM_CHILDREN; i++)
-			evals[num_chrs + i] = evaluation(children[i]);
-		int total = num_chrs + NUM_CHILDREN;
-		std::sort(evals + num_chrs, evals + total);
-		int p = 0, q = num_chrs, r = 0;
-		while (p < num_chrs || q < total) {
-			if (p == num_chrs)
-				temp[r] = evals[q++];
-			else if (q == total)
-				temp[r] = evals[p++];
-			else {
-				if (evals[p] < evals[q])
-					temp[r] = evals[p++];
+	// members past population_size, if it shrank, are taken in like children
+	if (num_islands > 1)
+		islands.resize(num_islands);
+	for (int k = 0; k < num_islands; k++) {
+		population &pop = num_islands == 1 ? group : islands[k];
+		pop.allocate();
+		int n = 0;
+		for (int i = ranges[k].first; i < ranges[k].second; i++) {
+			evaluation eval(all[i]);
+			if (pop.num_chrs < population_size) {
+				if (pop.hashes.insert(eval.hash))
+					pop.evals[pop.num_chrs++] = eval;
 				else
-					temp[r] = evals[q++];
-			}
-			r++;
-		}
-		evals[0] = temp[0];
-		chrs[0] = evals[0].chr;
-		num_chrs = 1;
-		for (int i = 1; i < total; i++) {
-			if (temp[i].score == temp[i - 1].score &&
-			    temp[i].hash == temp[i - 1].hash)
-				delete temp[i].chr;
-			else {
-				if (num_chrs < MAX_POPULATION) {
-					evals[num_chrs] = temp[i];
-					chrs[num_chrs] = temp[i].chr;
-					num_chrs++;
-				} else {
-					delete temp[i].chr;
+					delete all[i];
+				if (pop.num_chrs == population_size || i + 1 == ranges[k].second)
+					pop.heapify();
+			} else {
+				pop.children[n++] = all[i];
+				if (n == NUM_CHILDREN) {
+					pop.replace(n);
+					n = 0;
 				}
 			}
 		}
+		pop.replace(n);
 	}
-} group;
-
-void get_input() {
-	// get input
-	int u, v, w;
-	if (scanf("%d %d", &V, &E) != 2) exit(errno);
-	for (int i = 0; i < E; i++) {
-		if (scanf("%d %d %d", &u, &v, &w) != 3) exit(errno);
-		// change from 1-base to 0-base
-		u--;
-		v--;
-		edges[i][0] = u;
-		edges[i][1] = v;
-		edges[i][2] = w;
-		vertices[u].push_back(v);
-		vertices[v].push_back(u);
-	}
-
-	// set hash constant (2^V - 1)
-	hash_const = 1;
-	for (int i = 0; i < V; i++)
-		hash_const = (hash_const << 1) % MOD;
-	hash_const = (hash_const + MOD - 1) % MOD;
 }
 
-void dfs(int u) {
-	if (visits[u]) return;
-	visits[u] = 1;
-	renumbers[u] = renumber_cnt;
-	real_numbers[renumber_cnt] = u;
-	renumber_cnt++;
-	for (int v : vertices[u])
-		dfs(v);
-}
+// follows one population from generation to generation: when it restarts, and when it stops,
+// at the deadline, at the target score of any population or after stall_limit generations without improvement
+class run_controller {
+public:
+	int64_t best;
+	int stalled = 0;  // generations since best last improved
 
-void renumber() {
-	Q.emplace(0, rand() % V);
-	while (!Q.empty()) {
-		int u = Q.top().second;
-		Q.pop();
-		if (visits[u]) continue;
-		visits[u] = 1;
-		renumbers[u] = renumber_cnt++;
-		for (int v : vertices[u]) {
-			if (visits[v]) continue;
-			degrees[v]++;
-			Q.emplace(degrees[v], v);
+	run_controller(int64_t score) : best(score) {}
+
+	// after a generation, true if the population should restart now
+	bool update(int64_t score) {
+		if (score > best) {
+			best = score;
+			stalled = 0;
+			return false;
 		}
+		stalled++;
+		return restart_interval && stalled % restart_interval == 0;
 	}
-	for (int i = 0; i < V; i++)
-		std::sort(vertices[i].begin(), vertices[i].end(),
-			[&](int x, int y) {
-				return renumbers[x] < renumbers[y];
-			}
-		);
-	// concerns: some vertices cannot be visited
-	// but seeming there is no such vertex, all seem to be connected
-	std::memset(visits, 0, sizeof(visits));
-	renumber_cnt = 0;
-	for (int i = 0; i < V; i++)
-		dfs(i);
-	for (int i = 0; i < E; i++) {
-		edges[i][0] = renumbers[edges[i][0]];
-		edges[i][1] = renumbers[edges[i][1]];
-		infos[edges[i][0]].emplace_back(edges[i][1], edges[i][2]);
-		infos[edges[i][1]].emplace_back(edges[i][0], edges[i][2]);
+
+	bool finished() const {
+		return target_reached || (stall_limit && stalled >= stall_limit) || get_time() - starts_at >= time_limit;
 	}
-}
+};
 
-void try_GA() {
-	group = population();
+// runs generations on pop until its run_controller stops it, returns how many.
+// the only population takes its children from the worker pool, an island makes its own
+int evolve(population &pop, int id) {
+	workspace &ws = workspaces[id];
 	int cnt = 0;
+	PROBE(random_generator probe_rng(1));  // keeps the run itself the same as without TELEMETRY
+	PROBE(double probe_at = get_time());
+	PROBE(workspace *probe_wss = num_islands == 1 ? workspaces.data() : &ws);
+	PROBE(int probe_n = num_islands == 1 ? num_threads : 1);
+	double checkpoint_at = get_time() + checkpoint_interval;
+	run_controller control(pop.top.score);
 	do {
 		// int num_crossover = NUM_CHILDREN / 4;
 		// int num_mutation = NUM_CHILDREN / 2;
@@ -330,40 +2662,994 @@ void try_GA() {
 		// 	int x = rand() % group.num_chrs;
 		// 	group.children[i] = group.chrs[x]->mutation(true)->local_opt();
 		// }
-		for (int i = 0; i < NUM_CHILDREN; i++) {
-			int x = rand() % group.num_chrs;
-			int y = rand() % group.num_chrs;
-			group.children[i] = group.chrs[x]->crossover(group.chrs[y])  // always create new chromosome
-											 ->mutation(false)  // create new chromosome when flag is given
-											 ->local_opt();  // do not create new chromosome
-		}
-		group.replace();
+		PROBE(long long t = now_ns());
+		if (num_islands == 1) {
+			generate_children();
+		} else {
+			PHASE(ws.probe.busy);
+			for (int i = 0; i < NUM_CHILDREN; i++)
+				pop.children[i] = child_maker(pop, ws);
+		}
+		PROBE(lap(pop.probe.generate, t));
+		{
+			perf_scope perf(ws.perf, PERF_REPLACE);
+			pop.replace();
+			if (num_islands > 1)
+				migrate(pop, id, cnt + 1);
+		}
+		PROBE(lap(pop.probe.replace, t));
 		cnt++;
-		if (cnt % 100 == 0)
-			fprintf(stderr, "%d %d %lf\n", cnt, group.evals[0].score, get_time() - starts_at);
-	} while (get_time() - starts_at + SPARE_TIME < V / 6.0);
+		if (remote && id == 0 && cnt % migration_interval == 0)
+			exchange_remote(pop);
+		publish_best(pop.top.score);
+		if (control.update(pop.top.score)) {
+			pop.restart(ws.rng, RESTART_ELITE);
+			restarts++;
+		}
+		if (checkpoint_path && get_time() >= checkpoint_at) {
+			checkpoint_at += checkpoint_interval;
+			save_population(pop, id);
+		}
+		if (cnt % 100 == 0 && id == 0 && !quiet)
+			fprintf(stderr, "%d %lld %lf\n", cnt, (long long)(pop.top.score + reduced.offset), get_time() - starts_at);
+		PROBE(if (get_time() - probe_at >= TELEMETRY_INTERVAL) {
+			probe_at = get_time();
+			print_telemetry(pop, probe_wss, probe_n, id, cnt, probe_rng);
+		})
+	} while (!control.finished());
+	PROBE(print_telemetry(pop, probe_wss, probe_n, id, cnt, probe_rng));
+	return cnt;
+}
+
+SOLVER_STATE const char *seeds_path;  // -i: partitions taken into the first population, e.g. from multi_start -o
+
+// one partition per line in the output format, taken in like children,
+// so they only replace worse random members and duplicates are dropped
+void add_seeds(population &pop) {
+	FILE *file = fopen(seeds_path, "r");
+	if (!file) exit(errno);
+	char *line = nullptr;
+	size_t capacity = 0;
+	int n = 0;
+	while (getline(&line, &capacity, file) > 0) {
+		chromosome *chr = new chromosome();
+		bool empty = true;
+		char *p = line, *end;
+		for (long x; (x = strtol(p, &end, 10)), end != p; p = end) {
+			if (x < 1 || x > V) exit(EINVAL);
+			int i = renumbers[x - 1];
+			if (!chr->get(i))
+				chr->flip(i);
+			empty = false;
+		}
+		if (empty) {
+			delete chr;
+			continue;
+		}
+		pop.children[n++] = chr;
+		if (n == NUM_CHILDREN) {
+			pop.replace(n);
+			n = 0;
+		}
+	}
+	pop.replace(n);
+	free(line);
+	fclose(file);
+}
+
+void run_island(int id, int *generations) {
+	if (profile)
+		workspaces[id].perf.open();  // counts this thread only, a failure leaves its events out
+	*generations = evolve(islands[id], id);
+}
+
+void try_GA() {
+	if (num_islands > 1)
+		num_threads = num_islands;  // one thread per island, no worker pool
+	if (num_threads <= 0)
+		num_threads = std::max(1u, std::thread::hardware_concurrency());
+	for (int i = 0; i < num_threads; i++)
+		workspaces.emplace_back(seeder.next());
+	if (profile && !workspaces[0].perf.open()) {
+		fprintf(stderr, "perf: no hardware counters (%s), -P is ignored\n", strerror(errno));
+		profile = false;
+	}
+	std::vector<std::thread> workers;
+	if (num_islands == 1)
+		for (int i = 1; i < num_threads; i++)
+			workers.emplace_back(worker, i);
+
+	pool.init(chromosome::bytes(), huge_pages);
+	population_size = population_for(pool.slot_size);
+	if (!quiet)
+		report_memory();
+	snapshots.assign(num_islands, {});
+	double init_at = get_time();
+	{
+		perf_scope perf(workspaces[0].perf, PERF_INIT);
+		if (restore_path)
+			restore_checkpoint();
+		else if (num_islands == 1)
+			group = population(workspaces[0].rng);
+		else
+			for (int i = 0; i < num_islands; i++)
+				islands.emplace_back(workspaces[i].rng);
+		if (seeds_path) {
+			if (num_islands == 1)
+				add_seeds(group);
+			for (auto &island : islands)
+				add_seeds(island);
+		}
+	}
+	double loop_at = get_time();
+	int cnt = 0;
+	if (num_islands == 1) {
+		publish_best(group.top.score);
+		cnt = evolve(group, 0);
+		if (checkpoint_path)
+			save_population(group, 0);
+	} else {
+		mailboxes.reset(new mailbox[num_islands]);
+		for (auto &island : islands)
+			publish_best(island.top.score);
+		std::vector<int> generations(num_islands);
+		for (int i = 1; i < num_islands; i++)
+			workers.emplace_back(run_island, i, &generations[i]);
+		generations[0] = evolve(islands[0], 0);
+		for (auto &t : workers)
+			t.join();
+		workers.clear();
+		if (checkpoint_path) {
+			for (int i = 1; i < num_islands; i++)
+				save_population(islands[i], i);
+			save_population(islands[0], 0);
+		}
+		// the best island becomes group, the others and migrants still on the way are freed
+		int best = 0;
+		for (int i = 0; i < num_islands; i++) {
+			cnt += generations[i];
+			release_migrants(mailboxes[i].migrants.exchange(nullptr));
+			if (islands[i].top.score > islands[best].top.score)
+				best = i;
+		}
+		for (int i = 0; i < num_islands; i++)
+			if (i != best)
+				for (int j = 0; j < islands[i].num_chrs; j++)
+					delete islands[i].chrs[j];
+		group = std::move(islands[best]);
+		islands.clear();
+	}
+
+	stats.generations = cnt;
+	stats.restarts = restarts;
+	for (auto &ws : workspaces) {
+		stats.children += ws.children;
+		stats.local_opts += ws.local_opts;
+	}
+	stats.init = loop_at - init_at;
+	stats.loop = get_time() - loop_at;
+	if (print_stats)
+		print_run_stats();
+
+	{
+		std::lock_guard<std::mutex> lock(pool_mutex);
+		pool_stop = true;
+	}
+	pool_wakeup.notify_all();
+	for (auto &t : workers)
+		t.join();
+	if (!quiet)
+		pool.report();
+	if (profile)
+		print_perf();
+}
+
+// before renumber(): parallel edges become one with the summed weight, zero sums are dropped.
+// a vertex with a single neighbour left is folded, it goes opposite to the neighbour
+// for a positive weight and next to it otherwise, which is always optimal.
+// isolated vertices stay on side 0, the rest is split into connected components
+void reduce() {
+	std::vector<std::pair<uint64_t, int>> merged(E);
+	for (int64_t i = 0; i < E; i++) {
+		uint64_t u = std::min(G.edge_u[i], G.edge_v[i]), v = std::max(G.edge_u[i], G.edge_v[i]);
+		merged[i] = {u << 32 | v, G.edge_w[i]};
+	}
+	std::sort(merged.begin(), merged.end());
+	graph H;  // merged graph in input numbering
+	for (size_t i = 0; i < merged.size();) {
+		uint64_t key = merged[i].first;
+		int64_t w = 0;
+		for (; i < merged.size() && merged[i].first == key; i++)
+			w += merged[i].second;
+		if (w == 0) continue;
+		if (w > INT32_MAX / 2 || w < -INT32_MAX / 2) {
+			fprintf(stderr, "parallel edges sum up to %lld, too large\n", (long long)w);
+			exit(EINVAL);
+		}
+		H.edge_u.push_back(key >> 32);
+		H.edge_v.push_back(key & 0xFFFFFFFF);
+		H.edge_w.push_back(w);
+	}
+	std::vector<std::pair<uint64_t, int>>().swap(merged);
+	int64_t kept_E = H.edge_u.size();
+	H.build_adjacency();
+
+	std::vector<int> degrees(V);
+	std::vector<uint8_t> folded(V);
+	std::vector<int> leaves;
+	for (int u = 0; u < V; u++) {
+		degrees[u] = H.offsets[u + 1] - H.offsets[u];
+		if (degrees[u] == 1)
+			leaves.push_back(u);
+	}
+	while (!leaves.empty()) {
+		int u = leaves.back();
+		leaves.pop_back();
+		if (degrees[u] != 1) continue;  // its neighbour was folded meanwhile
+		int64_t i = H.offsets[u];
+		while (folded[H.neighbors[i]])
+			i++;
+		int v = H.neighbors[i], w = H.weights[i];
+		reduced.folds.emplace_back(u, v, w > 0);
+		reduced.offset += std::max(w, 0);
+		folded[u] = 1;
+		degrees[u] = 0;
+		if (--degrees[v] == 1)
+			leaves.push_back(v);
+	}
+
+	// components of what is left, by breadth-first search
+	reduced.component.assign(V, -1);
+	reduced.local.assign(V, -1);
+	std::vector<int> queue;
+	for (int root = 0; root < V; root++) {
+		if (degrees[root] == 0 || reduced.component[root] >= 0) continue;
+		int k = reduced.components.size();
+		queue.assign(1, root);
+		reduced.component[root] = k;
+		for (size_t j = 0; j < queue.size(); j++)
+			for (int64_t i = H.offsets[queue[j]]; i < H.offsets[queue[j] + 1]; i++) {
+				int v = H.neighbors[i];
+				if (!folded[v] && reduced.component[v] < 0) {
+					reduced.component[v] = k;
+					queue.push_back(v);
+				}
+			}
+		std::sort(queue.begin(), queue.end());
+		for (size_t j = 0; j < queue.size(); j++)
+			reduced.local[queue[j]] = j;
+		reduced.components.push_back(queue);
+	}
+	int isolated = 0, solved_V = 0;
+	for (int u = 0; u < V; u++) {
+		isolated += degrees[u] == 0 && !folded[u];
+		solved_V += reduced.component[u] >= 0;
+	}
+	if (kept_E == E && reduced.folds.empty() && isolated == 0 && reduced.components.size() == 1) {
+		reduced = reduction();  // nothing to take out
+		return;
+	}
+	// counting sort of the edges by component, so each component reads only its own
+	int num_components = reduced.components.size();
+	reduced.edges.assign(num_components + 1, 0);
+	for (int64_t i = 0; i < kept_E; i++)
+		if (reduced.component[H.edge_u[i]] >= 0 && reduced.component[H.edge_v[i]] >= 0)
+			reduced.edges[reduced.component[H.edge_u[i]] + 1]++;
+	for (int k = 0; k < num_components; k++)
+		reduced.edges[k + 1] += reduced.edges[k];
+	reduced.edge_u.resize(reduced.edges[num_components]);
+	reduced.edge_v.resize(reduced.edges[num_components]);
+	reduced.edge_w.resize(reduced.edges[num_components]);
+	std::vector<int64_t> fill(reduced.edges.begin(), reduced.edges.end() - 1);
+	for (int64_t i = 0; i < kept_E; i++)
+		if (reduced.component[H.edge_u[i]] >= 0 && reduced.component[H.edge_v[i]] >= 0) {
+			int64_t j = fill[reduced.component[H.edge_u[i]]]++;
+			reduced.edge_u[j] = H.edge_u[i];
+			reduced.edge_v[j] = H.edge_v[i];
+			reduced.edge_w[j] = H.edge_w[i];
+		}
+	reduced.input_V = V;
+	fprintf(stderr, "reduce: V %d -> %d, E %lld -> %lld, %zu folded, %d isolated, %zu components, offset %lld\n",
+	        V, solved_V, (long long)E, (long long)reduced.edge_u.size(), reduced.folds.size(), isolated,
+	        reduced.components.size(), (long long)reduced.offset);
+}
+
+// component k becomes the graph the solver sees, vertices numbered by reduced.local
+void use_component(int k) {
+	V = reduced.components[k].size();
+	G.edge_u.clear();
+	G.edge_v.clear();
+	G.edge_w.clear();
+	for (int64_t i = reduced.edges[k]; i < reduced.edges[k + 1]; i++) {
+		G.edge_u.push_back(reduced.local[reduced.edge_u[i]]);
+		G.edge_v.push_back(reduced.local[reduced.edge_v[i]]);
+		G.edge_w.push_back(reduced.edge_w[i]);
+	}
+	E = G.edge_u.size();
+}
+
+// sides[] of the input vertices with the components filled in: folded vertices follow
+// their neighbours in reverse fold order, then the 1-side is printed
+void print_sides(std::vector<uint8_t> &sides) {
+	for (auto it = reduced.folds.rbegin(); it != reduced.folds.rend(); ++it)
+		sides[std::get<0>(*it)] = sides[std::get<1>(*it)] ^ std::get<2>(*it);
+	for (size_t i = 0; i < sides.size(); i++)
+		if (sides[i])
+			printf("%zu ", i + 1);
+	printf("\n");
 }
 
 void print_output() {
-	chromosome *best = group.evals[0].chr;
+	chromosome *best = group.top.chr;
 
+	std::vector<uint8_t> sides(reduced.input_V ? reduced.input_V : V);
 	for (int i = 0; i < V; i++)
-		visits[real_numbers[i]] = best->genes[i];
-	for (int i = 0; i < V; i++)
-		if (visits[i])
-			printf("%d ", i + 1);
+		sides[reduced.input_V ? reduced.components[0][real_numbers[i]] : real_numbers[i]] = best->get(i);
+	print_sides(sides);
+}
+
+// maximum cut of component k by trying all 2^(n - 1) partitions with the first vertex on side 0,
+// in Gray code order so each one is a single flip away from the last
+int64_t solve_exactly(int k, std::vector<uint8_t> &sides) {
+	const std::vector<int> &vertices = reduced.components[k];
+	int n = vertices.size();
+	std::vector<std::vector<std::pair<int, int>>> adjacency(n);
+	for (int64_t i = reduced.edges[k]; i < reduced.edges[k + 1]; i++) {
+		int u = reduced.local[reduced.edge_u[i]], v = reduced.local[reduced.edge_v[i]];
+		adjacency[u].emplace_back(v, reduced.edge_w[i]);
+		adjacency[v].emplace_back(u, reduced.edge_w[i]);
+	}
+	uint64_t code = 0, best_code = 0;
+	int64_t cut = 0, best = 0;
+	for (uint64_t i = 1; i < 1ULL << (n - 1); i++) {
+		int u = __builtin_ctzll(i) + 1;
+		uint64_t side = code >> u & 1;
+		for (auto [v, w] : adjacency[u])
+			cut += (code >> v & 1) == side ? w : -w;
+		code ^= 1ULL << u;
+		if (cut > best) {
+			best = cut;
+			best_code = code;
+		}
+	}
+	for (int u = 0; u < n; u++)
+		sides[vertices[u]] = best_code >> u & 1;
+	return best;
+}
+
+// a reduced graph of several components, or of small ones only: small components are solved exactly here,
+// the others by forked processes running the GA on one component alone. there are at most as many processes
+// as threads: the components are dealt to lanes, largest first to the lane with the fewest vertices, and each
+// lane solves its components one after another, each until the lane's share of the time so far by V.
+// a lane has its V's share of the threads and population memory, and a component's population is what fits
+// in that memory for its V, up to MAX_POPULATION, as for an input of that size.
+// they report like -N workers to this process as their coordinator: it sums up their bests with the exact cuts
+// and stops them all once the sum reaches -o, then prints the stats and the stitched partition
+void solve_components(const char *kernel_name) {
+	std::vector<uint8_t> sides(reduced.input_V);
+	int64_t cut = 0;
+	if (target_score != INT64_MAX)
+		target_score -= reduced.offset;  // scores are of the reduced graph, publish_best() adds the offset
+	auto size = [](int k) { return (int64_t)reduced.components[k].size(); };
+	std::vector<int> large;
+	for (int k = 0; k < (int)reduced.components.size(); k++)
+		if (size(k) > EXACT_VERTICES)
+			large.push_back(k);
+	std::stable_sort(large.begin(), large.end(), [&](int a, int b) { return size(a) > size(b); });
+	int threads = num_threads > 0 ? num_threads : std::max(1u, std::thread::hardware_concurrency());
+	int num_lanes = std::min<int>(threads, large.size());
+	std::vector<std::vector<int>> lanes(num_lanes);
+	std::vector<int64_t> lane_V(num_lanes);
+	int64_t large_V = 0;
+	for (int k : large) {
+		int l = std::min_element(lane_V.begin(), lane_V.end()) - lane_V.begin();
+		lanes[l].push_back(k);
+		lane_V[l] += size(k);
+		large_V += size(k);
+	}
+	double lanes_at = get_time() - starts_at, budget = std::max(0.0, time_limit - lanes_at);
+
+	std::vector<std::unique_ptr<transport>> running(num_lanes);
+	std::vector<int> solving(num_lanes);  // component of the lane's process
+	std::vector<size_t> next(num_lanes);  // of lanes[l]
+	std::vector<int64_t> done_V(num_lanes);  // of the components the lane has started
+	std::vector<double> lane_init(num_lanes), lane_loop(num_lanes);
+	std::vector<pollfd> fds(num_lanes);
+	fflush(stdout);
+	auto start = [&](int l) {
+		int k = lanes[l][next[l]++];
+		done_V[l] += size(k);
+		int socks[2];
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, socks)) exit(errno);
+		pid_t pid = fork();
+		if (pid < 0) exit(errno);
+		if (pid == 0) {
+			close(socks[0]);
+			running.clear();
+			use_component(k);
+			num_threads = 1 + (threads - num_lanes) * lane_V[l] / large_V;
+			population_mb = std::max<int64_t>(1, population_mb * lane_V[l] / large_V);
+			time_limit = lanes_at + budget * done_V[l] / lane_V[l];  // a component done early leaves its time to the next
+			target_score = INT64_MAX;  // the target is for the sum, this process stops the children
+			print_stats = false;
+			quiet = true;  // this process prints for all
+			seeder = random_generator(seeder.next() + k);
+			remote.reset(new unix_transport(socks[1]));
+			prepare();
+			renumber();
+			select_kernel(kernel_name);
+			compact_weights();
+			try_GA();
+			finish_remote(group.top.chr);
+			exit(0);
+		}
+		close(socks[1]);
+		running[l].reset(new unix_transport(socks[0]));
+		solving[l] = k;
+		fds[l] = {running[l]->fd(), POLLIN, 0};
+	};
+	for (int l = 0; l < num_lanes; l++)
+		start(l);
+	for (int k = 0; k < (int)reduced.components.size(); k++)
+		if (size(k) <= EXACT_VERTICES)
+			cut += solve_exactly(k, sides);
+
+	int alive = num_lanes, reported = 0;
+	std::vector<int64_t> best(reduced.components.size(), INT64_MIN);  // of each large component
+	message_header h;
+	std::vector<uint64_t> payload;
+	while (alive) {
+		if (poll(fds.data(), num_lanes, -1) < 0) {
+			if (errno == EINTR) continue;
+			exit(errno);
+		}
+		for (int l = 0; l < num_lanes; l++) {
+			if (fds[l].fd < 0 || !fds[l].revents) continue;
+			int k = solving[l];
+			if (!receive_message(*running[l], h, payload)) {
+				fprintf(stderr, "component %d was not solved\n", k);
+				exit(ECHILD);
+			}
+			if (h.type == MSG_MIGRANTS) {  // components have no migrants for each other
+				send_message(*running[l], target_reached ? MSG_DONE : MSG_MIGRANTS, 0, {});
+				continue;
+			}
+			int64_t score = payload[h.type == MSG_BEST ? 0 : 6];
+			if (best[k] == INT64_MIN)
+				reported++;
+			best[k] = std::max(best[k], score);
+			if (reported == (int)large.size()) {
+				int64_t sum = cut;
+				for (int j : large)
+					sum += best[j];
+				publish_best(sum);
+			}
+			if (h.type != MSG_DONE) continue;
+			stats.generations += payload[0];
+			stats.children += payload[1];
+			stats.local_opts += payload[2];
+			double init, loop;
+			std::memcpy(&init, &payload[3], sizeof(double));
+			std::memcpy(&loop, &payload[4], sizeof(double));
+			lane_init[l] += init;
+			lane_loop[l] += loop;
+			stats.restarts += payload[5];
+			best[k] = score;
+			const std::vector<int> &vertices = reduced.components[k];
+			const uint64_t *genes = payload.data() + 8;
+			for (size_t v = 0; v < vertices.size(); v++)
+				sides[vertices[v]] = genes[v >> 6] >> (v & 63) & 1;
+			running[l].reset();
+			if (next[l] < lanes[l].size()) {
+				start(l);
+			} else {
+				fds[l].fd = -1;
+				alive--;
+			}
+		}
+	}
+	while (wait(nullptr) > 0)
+		;
+	for (int l = 0; l < num_lanes; l++) {
+		stats.init = std::max(stats.init, lane_init[l]);
+		stats.loop = std::max(stats.loop, lane_loop[l]);
+	}
+	for (int j : large)
+		cut += best[j];
+	publish_best(cut);
+	if (print_stats)
+		print_run_stats();
+	print_sides(sides);
+}
+
+// forks num_processes workers, each connected by a socket pair, or waits for them on listen_path.
+// true in the coordinator, false in a forked worker, which goes on with remote set
+bool start_processes(std::vector<std::unique_ptr<transport>> &workers, unsigned seed) {
+	if (listen_path) {
+		workers = unix_transport::accept_from(listen_path, num_processes);
+		return true;
+	}
+	for (int i = 0; i < num_processes; i++) {
+		int socks[2];
+		if (socketpair(AF_UNIX, SOCK_STREAM, 0, socks)) exit(errno);
+		pid_t pid = fork();
+		if (pid < 0) exit(errno);
+		if (pid == 0) {
+			close(socks[0]);
+			workers.clear();
+			remote.reset(new unix_transport(socks[1]));
+			seeder = random_generator(seed + i + 1);
+			// each worker keeps its own checkpoint, path.i
+			static std::string own_checkpoint, own_restore;
+			if (checkpoint_path)
+				checkpoint_path = (own_checkpoint = std::string(checkpoint_path) + "." + std::to_string(i)).c_str();
+			if (restore_path)
+				restore_path = (own_restore = std::string(restore_path) + "." + std::to_string(i)).c_str();
+			print_stats = false;  // the coordinator reports for all
+			// without -j the workers share the hardware threads instead of each taking all of them
+			if (num_threads <= 0)
+				num_threads = std::max(1u, std::thread::hardware_concurrency() / num_processes);
+			return false;
+		}
+		close(socks[1]);
+		workers.emplace_back(new unix_transport(socks[0]));
+	}
+	return true;
+}
+
+// the coordinator runs no GA. it answers each batch of migrants with the last batch another worker
+// sent to this one, prints improvements and writes the best final partition of all workers
+void coordinate(std::vector<std::unique_ptr<transport>> &workers) {
+	int n = workers.size(), alive = n;
+	std::vector<std::vector<uint64_t>> pending(n);  // a newer batch for a worker replaces the older one
+	std::vector<std::vector<uint64_t>> delivered(n);  // hashes already sent to each worker
+	std::vector<pollfd> fds(n);
+	for (int i = 0; i < n; i++)
+		fds[i] = {workers[i]->fd(), POLLIN, 0};
+	random_generator rng(seeder.next());
+	std::vector<uint64_t> best, payload;
+	message_header h;
+	while (alive) {
+		if (poll(fds.data(), n, -1) < 0) {
+			if (errno == EINTR) continue;
+			exit(errno);
+		}
+		for (int i = 0; i < n; i++) {
+			if (fds[i].fd < 0 || !fds[i].revents) continue;
+			if (!receive_message(*workers[i], h, payload)) {
+				fds[i].fd = -1;  // poll() skips it from now on
+				alive--;
+				continue;
+			}
+			if (h.type == MSG_BEST) {
+				publish_best(payload[0]);
+			} else if (h.type == MSG_MIGRANTS && target_reached) {
+				send_message(*workers[i], MSG_DONE, 0, {});  // the worker stops
+			} else if (h.type == MSG_MIGRANTS) {
+				std::vector<uint64_t> reply;
+				std::swap(reply, pending[i]);
+				if (n > 1) {
+					int to = random_topology ? (i + 1 + rng(n - 1)) % n : (i + 1) % n;
+					pending[to].clear();
+					for (size_t j = 0; j + wire_words() <= payload.size(); j += wire_words()) {
+						auto &seen = delivered[to];
+						if (std::find(seen.begin(), seen.end(), payload[j + 1]) != seen.end()) continue;
+						if (seen.size() == DELIVERED_HASHES)
+							seen.erase(seen.begin());
+						seen.push_back(payload[j + 1]);
+						pending[to].insert(pending[to].end(), payload.begin() + j, payload.begin() + j + wire_words());
+					}
+				}
+				send_message(*workers[i], MSG_MIGRANTS, reply.size() / wire_words(), reply);
+			} else if (h.type == MSG_DONE) {
+				stats.generations += payload[0];
+				stats.children += payload[1];
+				stats.local_opts += payload[2];
+				double init, loop;
+				std::memcpy(&init, &payload[3], sizeof(double));
+				std::memcpy(&loop, &payload[4], sizeof(double));
+				stats.init = std::max(stats.init, init);
+				stats.loop = std::max(stats.loop, loop);
+				stats.restarts += payload[5];
+				if (best.empty() || (int64_t)payload[6] > (int64_t)best[0])
+					best.assign(payload.begin() + 6, payload.end());
+				publish_best(payload[6]);
+				fds[i].fd = -1;
+				alive--;
+			}
+		}
+	}
+	while (wait(nullptr) > 0)
+		;
+	if (print_stats)
+		print_run_stats();
+	if (best.empty()) {
+		fprintf(stderr, "no worker finished\n");
+		exit(ECHILD);
+	}
+	const uint64_t *genes = best.data() + 2;
+	for (int v = 0; v < V; v++)
+		if (genes[v >> 6] >> (v & 63) & 1)
+			printf("%d ", v + 1);
 	printf("\n");
 }
 
-int main() {
+SOLVER_STATE const char *binary_path;
+
+// cut value of the partition in path (1-based vertices of one side), for checking outputs
+// cut of a partition of the input, before renumber()
+int64_t cut_of(const char *path) {
+	FILE *file = fopen(path, "r");
+	if (!file) exit(errno);
+	std::vector<uint8_t> sides(V);
+	int x;
+	while (fscanf(file, "%d", &x) == 1) {
+		if (x < 1 || x > V) exit(EINVAL);
+		sides[renumbered ? renumbers[x - 1] : x - 1] = 1;
+	}
+	fclose(file);
+	int64_t cut = 0;
+	for (int64_t i = 0; i < E; i++)
+		if (sides[G.edge_u[i]] != sides[G.edge_v[i]])
+			cut += G.edge_w[i];
+	return cut;
+}
+
+}  // namespace
+
+#ifndef MAXCUT_LIBRARY
+int main(int argc, char **argv) {
 	// get start time
 	starts_at = get_time();
 
-	// srand, rand is fast, we do not need true-randomness
-	srand(time(NULL));
+	int opt;
+	unsigned seed = time(NULL);
+	const char *cut_path = nullptr;
+	const char *target_arg = nullptr;
+	const char *kernel_name = nullptr;
+	bool verify = false;
+	bool reduce_graph = true;
+	while ((opt = getopt(argc, argv, "j:g:m:Hb:t:s:SPe:i:I:K:M:T:N:L:W:k:vl:n:u:c:C:r:o:x:R:DO:")) != -1) {
+		switch (opt) {
+		case 'j':  // number of threads generating children
+			num_threads = atoi(optarg);
+			break;
+		case 'g':  // memory for cached gains in MB, 0 rescans all edges per child
+			gain_cache_mb = atoi(optarg);
+			break;
+		case 'm':  // memory for chromosomes in MB, limits the population of huge graphs
+			population_mb = atoi(optarg);
+			break;
+		case 'H':  // back the chromosome pool with huge pages
+			huge_pages = true;
+			break;
+		case 'b':  // save the renumbered graph, it can be given as input later
+			binary_path = optarg;
+			break;
+		case 't':  // seconds to run, V / 6 - SPARE_TIME by default
+			time_limit = atof(optarg);
+			break;
+		case 'o':  // stop at this cut, or at the cut of this partition, e.g. input/sol_g1.txt
+			target_arg = optarg;
+			break;
+		case 'x':  // stop after this many generations without improvement
+			stall_limit = atoi(optarg);
+			break;
+		case 'R':  // restart after this many generations without improvement, keeping the elite
+			restart_interval = atoi(optarg);
+			break;
+		case 's':  // random seed, the run is repeatable with -j 1
+			seed = strtoul(optarg, nullptr, 10);
+			break;
+		case 'S':  // report improvements and throughput on stderr
+			print_stats = true;
+			break;
+		case 'P':  // count cycles, instructions, cache misses and branch misses per phase
+			profile = true;
+			break;
+		case 'k':  // evaluation kernel, scalar, avx2 or avx512, the fastest supported one by default
+			kernel_name = optarg;
+			break;
+		case 'v':  // check the supported kernels against the scalar one and exit
+			verify = true;
+			break;
+		case 'i':  // start from these partitions, one per line, as written by multi_start -o
+			seeds_path = optarg;
+			break;
+		case 'I':  // number of islands, each with its own population and thread
+			num_islands = std::max(1, atoi(optarg));
+			break;
+		case 'K':  // generations between migrations
+			migration_interval = std::max(1, atoi(optarg));
+			break;
+		case 'M':  // migrants sent by an island each time
+			num_migrants = std::min(std::max(0, atoi(optarg)), NUM_CHILDREN);
+			break;
+		case 'T':  // migration topology, ring or random
+			if (strcmp(optarg, "ring") && strcmp(optarg, "random")) {
+				fprintf(stderr, "unknown topology %s\n", optarg);
+				return 1;
+			}
+			random_topology = !strcmp(optarg, "random");
+			break;
+		case 'N':  // worker processes, this one only coordinates them. without -j they split the hardware threads
+			num_processes = atoi(optarg);
+			break;
+		case 'L':  // coordinator socket the -N workers connect to, instead of forking them
+			listen_path = optarg;
+			break;
+		case 'W':  // run as a worker of the coordinator on this socket
+			worker_path = optarg;
+			break;
+		case 'l':  // local search after the descent of every child, greedy (none) or tabu
+			for (int i = 0; i <= TABU_SEARCH; i++)
+				if (!strcmp(optarg, local_search_names[i]))
+					local_search = (decltype(local_search))i;
+			if (strcmp(optarg, local_search_names[local_search])) {
+				fprintf(stderr, "unknown local search %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'n':  // moves of one tabu search
+			tabu_iterations = atoi(optarg);
+			break;
+		case 'u':  // seconds of one tabu search, before -n moves if that comes first
+			tabu_seconds = atof(optarg);
+			break;
+		case 'c':  // save the populations to this file now and then, and at the end
+			checkpoint_path = optarg;
+			break;
+		case 'C':  // seconds between checkpoints
+			checkpoint_interval = atof(optarg);
+			break;
+		case 'r':  // continue from a checkpoint of the same graph and number of islands
+			restore_path = optarg;
+			break;
+		case 'O':  // vertex ordering, dfs, rcm, grid or spectral
+			for (int i = 0; i <= SPECTRAL_ORDER; i++)
+				if (!strcmp(optarg, ordering_names[i]))
+					ordering = (decltype(ordering))i;
+			if (strcmp(optarg, ordering_names[ordering])) {
+				fprintf(stderr, "unknown ordering %s\n", optarg);
+				return 1;
+			}
+			break;
+		case 'D':  // solve the graph as it is, without reduce()
+			reduce_graph = false;
+			break;
+		case 'e':  // only print the cut value of a partition of the input
+			cut_path = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-j threads] [-g gain cache MB] [-m population MB] [-H] [-b binary graph]\n"
+			                "          [-t seconds] [-o target] [-x stall] [-R restart] [-s seed] [-S] [-P] [-e partition] [-i seeds]\n"
+			                "          [-I islands] [-K migration interval] [-M migrants] [-T ring|random]\n"
+			                "          [-N processes [-L socket]] [-W socket] [-k kernel] [-v]\n"
+			                "          [-l greedy|tabu] [-n tabu moves] [-u tabu seconds]\n"
+			                "          [-c checkpoint [-C seconds]] [-r checkpoint] [-D]\n"
+			                "          [-O dfs|rcm|grid|spectral] < input > output\n", argv[0]);
+			return 1;
+		}
+	}
+
+	// the setup and every generator follow from the seed, we do not need true-randomness
+	seeder = random_generator(seed);
 
 	get_input();
-	renumber();
+	if (cut_path) {
+		printf("%lld\n", (long long)cut_of(cut_path));
+		return 0;
+	}
+	if (target_arg) {
+		char *end;
+		target_score = strtoll(target_arg, &end, 10);
+		if (*end || end == target_arg)
+			target_score = cut_of(target_arg);
+	}
+	if (time_limit < 0)
+		time_limit = V / 6.0 - SPARE_TIME;
+	// options naming input vertices or the whole graph's layout keep it as it is
+	if (reduce_graph && !renumbered && !num_processes && !listen_path && !worker_path && !seeds_path &&
+	    !binary_path && !checkpoint_path && !restore_path)
+		reduce();
+	if (reduced.input_V && (reduced.components.size() != 1 || reduced.components[0].size() <= EXACT_VERTICES)) {
+		solve_components(kernel_name);
+		fprintf(stderr, "solve: %lf\n", get_time() - starts_at);
+		return 0;
+	}
+	if (reduced.input_V) {
+		use_component(0);
+		if (target_score != INT64_MAX)
+			target_score -= reduced.offset;
+	}
+	prepare();
+	if (renumbered)
+		find_leftmost();
+	else
+		renumber();
+	if (binary_path)
+		write_binary(binary_path);
+	select_kernel(kernel_name);
+	compact_weights();
+	if (verify)
+		return verify_kernels() ? 0 : 1;
+	double solve_at = get_time();
+	fprintf(stderr, "startup: %lf\n", solve_at - starts_at);
+	if (num_processes > 0) {
+		std::vector<std::unique_ptr<transport>> workers;
+		if (start_processes(workers, seed)) {
+			coordinate(workers);
+			fprintf(stderr, "solve: %lf\n", get_time() - solve_at);
+			return 0;
+		}
+	} else if (worker_path) {
+		remote = unix_transport::connect_to(worker_path);
+	}
 	try_GA();
+	if (remote) {
+		finish_remote(group.top.chr);
+		return 0;
+	}
 	print_output();
+	fprintf(stderr, "solve: %lf\n", get_time() - solve_at);
+}
+#else
+namespace maxcut {
+
+bool Graph::add_edge(int u, int v, int w) {
+	if (u < 0 || u >= num_vertices || v < 0 || v >= num_vertices) return false;
+	edge_u.push_back(u);
+	edge_v.push_back(v);
+	edge_w.push_back(w);
+	return true;
+}
+
+int64_t Graph::cut(const std::vector<uint8_t> &sides) const {
+	int64_t cut = 0;
+	for (size_t i = 0; i < edge_u.size(); i++)
+		if (sides[edge_u[i]] != sides[edge_v[i]])
+			cut += edge_w[i];
+	return cut;
+}
+
+// what parse_text() and prepare() exit on, nullptr if the graph can be solved
+static const char *check(const Graph &input) {
+	size_t n = input.edge_u.size();
+	if (input.num_vertices < 0 || input.edge_v.size() != n || input.edge_w.size() != n)
+		return "edge_u, edge_v and edge_w differ in length";
+	std::vector<int64_t> weighted_degrees(input.num_vertices);
+	for (size_t i = 0; i < n; i++) {
+		int u = input.edge_u[i], v = input.edge_v[i];
+		if (u < 0 || u >= input.num_vertices || v < 0 || v >= input.num_vertices)
+			return "an edge has an end that is not a vertex";
+		if (u == v) continue;
+		weighted_degrees[u] += abs(input.edge_w[i]);
+		weighted_degrees[v] += abs(input.edge_w[i]);
+	}
+	for (int64_t degree : weighted_degrees)
+		if (degree > INT32_MAX / 2)
+			return "weights around a vertex sum up to too much";
+	return nullptr;
+}
+
+// the chromosome pool, graph and workspaces go back to the system, a later solve maps them anew
+void release() {
+	pool.unmap();
+	G = graph();
+	Q = std::priority_queue<std::pair<int, int>>();
+	std::vector<uint64_t>().swap(zobrist);
+	std::vector<uint8_t>().swap(visits);
+	std::vector<int>().swap(renumbers);
+	std::vector<int>().swap(real_numbers);
+	std::vector<int>().swap(leftmost);
+	std::vector<workspace>().swap(workspaces);
+	std::vector<population>().swap(islands);
+	std::vector<std::vector<uint64_t>>().swap(snapshots);
+	mailboxes.reset();
+	group = population();
+	reduced = reduction();
+}
+
+// main() on one thread, without reduce() and the options for files and processes.
+// the state this thread kept from its last solve is set up anew, the chromosome pool
+// is carved again if Solver::keep_memory left it mapped
+static Result run_solve(const Graph &input, const Solver &options) {
+	Result result;
+	if ((result.error = check(input)) || input.num_vertices == 0)
+		return result;
+	starts_at = get_time();
+	quiet = !options.verbose;
+	seeder = random_generator(options.seed);
+	static std::once_flag cpu_detected;  // before threads ask __builtin_cpu_supports() at once
+	std::call_once(cpu_detected, [] { __builtin_cpu_init(); });
+
+	G = graph();
+	V = input.num_vertices;
+	for (size_t i = 0; i < input.edge_u.size(); i++)
+		if (input.edge_u[i] != input.edge_v[i]) {
+			G.edge_u.push_back(input.edge_u[i]);
+			G.edge_v.push_back(input.edge_v[i]);
+			G.edge_w.push_back(input.edge_w[i]);
+		}
+	E = G.edge_u.size();
+	time_limit = options.time_limit < 0 ? V / 6.0 - SPARE_TIME : options.time_limit;
+	target_score = options.target;
+	stall_limit = options.stall_limit;
+	restart_interval = options.restart_interval;
+	population_mb = options.population_mb < 0 ? POPULATION_MB : options.population_mb;
+	gain_cache_mb = options.gain_cache_mb < 0 ? GAIN_CACHE_MB : options.gain_cache_mb;
+	local_search = options.tabu ? TABU_SEARCH : GREEDY_SEARCH;
+	tabu_iterations = options.tabu_iterations < 0 ? TABU_ITERATIONS : options.tabu_iterations;
+	num_threads = 1;
+	num_islands = 1;
+	renumber_cnt = 0;
+	workspaces.clear();
+	stats = run_stats();
+	best_score = INT64_MIN;
+	target_reached = false;
+	restarts = 0;
+
+	prepare();
+	renumber();
+	select_kernel(nullptr);
+	compact_weights();
+	try_GA();
+	chromosome *best = group.top.chr;
+	result.cut = group.top.score;
+	result.sides.resize(V);
+	for (int i = 0; i < V; i++)
+		result.sides[real_numbers[i]] = best->get(i);
+	result.generations = stats.generations;
+	// the slots go back to the pool for the next solve
+	for (int i = 0; i < group.num_chrs; i++)
+		delete group.chrs[i];
+	group = population();
+	if (!options.keep_memory)
+		release();
+	result.seconds = get_time() - starts_at;
+	return result;
+}
+
+// what the command line would exit on fails this solve only, with whatever it left behind released
+static Result solve_one(const Graph &input, const Solver &options) {
+	Result result;
+	try {
+		return run_solve(input, options);
+	} catch (const std::bad_alloc &) {
+		result.error = "the solver ran out of memory";
+	} catch (const std::exception &) {
+		result.error = "the solver failed";
+	}
+	release();
+	return result;
+}
+
+Result Solver::solve(const Graph &graph) const {
+	return solve_one(graph, *this);
 }
+
+// the calling thread takes part, every thread takes the next graph until none is left
+std::vector<Result> Solver::solve_all(const std::vector<Graph> &graphs, int threads) const {
+	std::vector<Result> results(graphs.size());
+	if (threads <= 0)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = std::max<size_t>(1, std::min<size_t>(threads, graphs.size()));
+	std::atomic<size_t> next{0};
+	auto work = [&] {
+		Solver options = *this;
+		for (size_t i; (i = next++) < graphs.size();) {
+			options.seed = seed + i;
+			results[i] = solve_one(graphs[i], options);
+		}
+	};
+	std::vector<std::thread> workers;
+	for (int t = 1; t < threads; t++)
+		workers.emplace_back(work);
+	work();
+	for (auto &t : workers)
+		t.join();
+	return results;
+}
+
+}  // namespace maxcut
+#endif
@@ -0,0 +1,67 @@
+// the GA of ga.cpp as a library, make libmaxcut.a and link with -pthread.
+// a solve keeps its state in thread_local variables of the thread it runs on, so solves on
+// different threads run at the same time and share nothing. each solve uses its own thread only,
+// solve_all() spreads a batch of graphs over a pool of threads.
+// the memory of a solve is given back when it returns, unless Solver::keep_memory asks to keep it
+// for the next solve on the same thread
+#ifndef MAXCUT_H
+#define MAXCUT_H
+
+#include <cstdint>
+#include <vector>
+
+namespace maxcut {
+
+// undirected graph with integer weights, vertices 0 .. num_vertices - 1.
+// parallel edges are kept, loops are dropped like in the text input
+class Graph {
+public:
+	int num_vertices = 0;
+	std::vector<int> edge_u, edge_v, edge_w;
+
+	Graph(int num_vertices_ = 0) : num_vertices(num_vertices_) {}
+
+	// false if u or v is not a vertex
+	bool add_edge(int u, int v, int w = 1);
+
+	// weight of the edges between side 0 and side 1
+	int64_t cut(const std::vector<uint8_t> &sides) const;
+};
+
+class Result {
+public:
+	int64_t cut = 0;
+	std::vector<uint8_t> sides;  // 0 or 1 per vertex
+	long long generations = 0;
+	double seconds = 0;
+	const char *error = nullptr;  // why the graph was not solved, nullptr if it was
+};
+
+// the options of ga that make sense for one graph, a negative number takes the default of ga
+class Solver {
+public:
+	double time_limit = -1;  // -t, V / 6 - 1 seconds if negative
+	uint64_t seed = 1;  // -s, solve_all() takes seed + i for graphs[i]
+	int64_t target = INT64_MAX;  // -o
+	int stall_limit = 0;  // -x
+	int restart_interval = 0;  // -R
+	int population_mb = -1;  // -m
+	int gain_cache_mb = -1;  // -g
+	bool tabu = false;  // -l tabu
+	int tabu_iterations = -1;  // -n
+	bool verbose = false;  // the progress lines of ga on stderr
+	bool keep_memory = false;  // the chromosome pool stays mapped for the next solve of this thread, see release()
+
+	Result solve(const Graph &graph) const;
+
+	// results[i] is the one of graphs[i], repeatable whatever thread solved it.
+	// threads = 0 starts one per hardware thread
+	std::vector<Result> solve_all(const std::vector<Graph> &graphs, int threads = 0) const;
+};
+
+// gives back what solves with keep_memory left on the calling thread
+void release();
+
+}  // namespace maxcut
+
+#endif
@@ -0,0 +1,136 @@
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cerrno>
+#include <cstring>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <vector>
+#include <string>
+#include <algorithm>
+
+#include "common.h"
+
+// sends graphs in the input format to maxcut_server -L socket, each file -r times, and prints
+// a line per answer as it comes: the file, the cut and the seconds since the requests were sent.
+// -o dir writes the partitions to dir/<file name>, they can be checked with ga -e.
+// without -L the requests only go to stdout, for a server reading stdin:
+//
+//   ./maxcut_client -t 1 input/g*.txt | ./maxcut_server > answers
+
+// the request line of a graph file: id, time budget, then the file with its line breaks taken out
+std::string request_line(int id, const char *budget, const char *path) {
+	FILE *file = fopen(path, "r");
+	if (!file) {
+		fprintf(stderr, "cannot read %s\n", path);
+		exit(errno);
+	}
+	std::string line = std::to_string(id) + " " + budget + " ";
+	char chunk[1 << 16];
+	size_t n;
+	while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0)
+		line.append(chunk, n);
+	fclose(file);
+	std::replace(line.begin(), line.end(), '\n', ' ');
+	std::replace(line.begin(), line.end(), '\r', ' ');
+	return line + "\n";
+}
+
+bool send_all(int fd, const std::string &data) {
+	const char *p = data.data();
+	size_t size = data.size();
+	while (size) {
+		ssize_t n = write(fd, p, size);
+		if (n < 0 && errno == EINTR) continue;
+		if (n <= 0) return false;
+		p += n;
+		size -= n;
+	}
+	return true;
+}
+
+int main(int argc, char **argv) {
+	int opt;
+	const char *budget = "-1";
+	const char *socket_path = nullptr;
+	const char *out_dir = nullptr;
+	int repeat = 1;
+	while ((opt = getopt(argc, argv, "t:r:o:L:")) != -1) {
+		switch (opt) {
+		case 't':  // seconds for each solve, V / 6 - 1 by default
+			budget = optarg;
+			break;
+		case 'r':  // send every file this many times
+			repeat = std::max(1, atoi(optarg));
+			break;
+		case 'o':  // write the partition of each file to this directory
+			out_dir = optarg;
+			break;
+		case 'L':  // socket of maxcut_server -L, requests go to stdout without it
+			socket_path = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-t seconds] [-r repeat] [-o dir] [-L socket] file...\n", argv[0]);
+			return 1;
+		}
+	}
+	std::vector<const char *> paths;  // of request i
+	for (int r = 0; r < repeat; r++)
+		for (int i = optind; i < argc; i++)
+			paths.push_back(argv[i]);
+
+	int sock = 1;
+	if (socket_path) {
+		sockaddr_un addr;
+		std::memset(&addr, 0, sizeof(addr));
+		addr.sun_family = AF_UNIX;
+		if (strlen(socket_path) >= sizeof(addr.sun_path)) exit(ENAMETOOLONG);
+		strcpy(addr.sun_path, socket_path);
+		sock = socket(AF_UNIX, SOCK_STREAM, 0);
+		if (sock < 0 || connect(sock, (sockaddr *)&addr, sizeof(addr))) {
+			fprintf(stderr, "cannot connect to %s\n", socket_path);
+			exit(errno);
+		}
+	}
+	double sent_at = get_time();
+	for (size_t i = 0; i < paths.size(); i++)
+		if (!send_all(sock, request_line(i, budget, paths[i]))) {
+			fprintf(stderr, "the server went away\n");
+			exit(EPIPE);
+		}
+	if (!socket_path) return 0;
+	shutdown(sock, SHUT_WR);  // the server sees the end of the requests
+
+	FILE *in = fdopen(sock, "r");
+	char *line = nullptr;
+	size_t capacity = 0;
+	int answered = 0;
+	while (answered < (int)paths.size() && getline(&line, &capacity, in) > 0) {
+		char *p = line, *end;
+		long id = strtol(p, &end, 10);
+		if (end == p || id < 0 || id >= (long)paths.size()) continue;
+		answered++;
+		p = end + strspn(end, " ");
+		long long cut = strtoll(p, &end, 10);
+		if (end == p) {  // "<id> error <reason>"
+			printf("%s %s", paths[id], p);
+			continue;
+		}
+		printf("%s %lld %.3lf\n", paths[id], cut, get_time() - sent_at);
+		fflush(stdout);
+		if (out_dir) {
+			const char *name = strrchr(paths[id], '/');
+			std::string out = std::string(out_dir) + "/" + (name ? name + 1 : paths[id]);
+			FILE *file = fopen(out.c_str(), "w");
+			if (!file) exit(errno);
+			fprintf(file, "%s", end + strspn(end, " "));
+			fclose(file);
+		}
+	}
+	free(line);
+	fclose(in);
+	fprintf(stderr, "%d of %zu answered in %lf s\n", answered, paths.size(), get_time() - sent_at);
+	return answered == (int)paths.size() ? 0 : 1;
+}
@@ -0,0 +1,297 @@
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cerrno>
+#include <cstring>
+#include <cstdint>
+#include <climits>
+#include <csignal>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <memory>
+#include <new>
+
+#include "maxcut.h"
+#include "common.h"
+
+#define NUM_THREADS 0  // 0: one solver thread per hardware thread, overridden by -j
+
+// keeps libmaxcut.a running and solves graphs sent to it, one request per line, from stdin or from
+// the clients of a Unix socket (-L). every request is answered on its own line as soon as it is solved,
+// so answers can come in another order than the requests:
+//
+//   request: <id> <seconds> <V> <E> <u> <v> <w> ...  the input format on one line, after an id and a time budget
+//   answer:  <id> <cut> <vertices of side 1>  or  <id> error <reason>
+//
+// requests wait in one queue for the solver threads. a solver thread keeps its chromosome pool
+// from one request to the next, see Solver::keep_memory, so only its first requests map memory.
+// every answer is logged on stderr with the queue depth, the wait, the solve time and the latency
+
+double starts_at;
+
+int num_threads = NUM_THREADS;
+const char *listen_path;  // -L: clients connect here, otherwise requests come from stdin
+maxcut::Solver options;  // what every solve takes but the time budget, which comes with each request
+
+// where the answers of one client go, kept alive by its requests still in the queue
+class client {
+public:
+	int out;
+	bool own;  // out is a socket closed with the client, not stdout
+	std::mutex mutex;  // one answer line at a time
+	bool gone = false;  // a write failed, later answers are dropped
+
+	client(int out_, bool own_) : out(out_), own(own_) {}
+
+	~client() {
+		if (own)
+			close(out);
+	}
+
+	void answer(const std::string &line) {
+		std::lock_guard<std::mutex> lock(mutex);
+		const char *p = line.data();
+		size_t size = line.size();
+		while (!gone && size) {
+			ssize_t n = write(out, p, size);
+			if (n < 0 && errno == EINTR) continue;
+			if (n <= 0) gone = true;
+			p += n;
+			size -= n;
+		}
+	}
+};
+
+class request {
+public:
+	std::string id;
+	double budget;  // seconds of the solve, V / 6 - 1 if negative
+	maxcut::Graph graph;
+	std::shared_ptr<client> from;
+	long long number;  // in order of arrival, seeds the solve
+	double arrived;
+	int depth;  // requests queued when it arrived, itself included
+};
+
+std::mutex queue_mutex;
+std::condition_variable queue_wakeup;
+std::deque<request> queue;
+bool closing;  // no more requests come, the solver threads end with the queue
+long long received, served;
+int max_depth;
+double total_latency;
+
+// the request on line, nullptr or why it cannot be solved. id stays empty on a blank line
+const char *parse(const char *p, request &r) {
+	p += strspn(p, " \t\r\n");
+	size_t length = strcspn(p, " \t\r\n");
+	if (length == 0) return nullptr;
+	r.id.assign(p, length);
+	p += length;
+	char *end;
+	r.budget = strtod(p, &end);
+	if (end == p) return "no time budget";
+	p = end;
+	long long n = strtoll(p, &end, 10);
+	if (end == p || n < 0 || n > INT_MAX) return "no vertex count";
+	p = end;
+	long long m = strtoll(p, &end, 10);
+	if (end == p || m < 0) return "no edge count";
+	p = end;
+	// an edge takes at least 6 characters, " u v w", so the line bounds what E may reserve
+	if (m > (long long)(strlen(p) + 1) / 6) return "more edges than the line holds";
+	r.graph = maxcut::Graph(n);
+	r.graph.edge_u.reserve(m);
+	r.graph.edge_v.reserve(m);
+	r.graph.edge_w.reserve(m);
+	for (long long i = 0; i < m; i++) {
+		long x[3];
+		for (long &value : x) {
+			value = strtol(p, &end, 10);
+			if (end == p) return "fewer edges than E";
+			p = end;
+		}
+		// 1-based like the input file
+		if (!r.graph.add_edge(x[0] - 1, x[1] - 1, x[2])) return "an edge has an end that is not a vertex";
+	}
+	p += strspn(p, " \t\r\n");
+	if (*p) return "more numbers than E edges";
+	return nullptr;
+}
+
+// one request per line until the client stops sending
+void read_requests(FILE *in, std::shared_ptr<client> from) {
+	char *line = nullptr;
+	size_t capacity = 0;
+	while (getline(&line, &capacity, in) > 0) {
+		request r;
+		const char *error;
+		try {
+			error = parse(line, r);
+		} catch (const std::bad_alloc &) {
+			error = "the graph does not fit in memory";  // of this request only, the others go on
+		}
+		if (r.id.empty()) continue;
+		if (error) {
+			from->answer(r.id + " error " + error + "\n");
+			continue;
+		}
+		r.from = from;
+		r.arrived = get_time();
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		r.number = received++;
+		r.depth = queue.size() + 1;
+		max_depth = std::max(max_depth, r.depth);
+		queue.push_back(std::move(r));
+		queue_wakeup.notify_one();
+	}
+	free(line);
+	fclose(in);
+}
+
+// takes requests from the queue until it is closed and empty. the thread_local state of the solver,
+// and with it the chromosome pool, lives as long as this thread
+void solve_requests() {
+	while (true) {
+		request r;
+		{
+			std::unique_lock<std::mutex> lock(queue_mutex);
+			queue_wakeup.wait(lock, [] { return closing || !queue.empty(); });
+			if (queue.empty()) return;
+			r = std::move(queue.front());
+			queue.pop_front();
+		}
+		double started = get_time();
+		maxcut::Solver solver = options;
+		solver.time_limit = r.budget;
+		solver.seed = options.seed + r.number;
+		maxcut::Result result;
+		try {
+			result = solver.solve(r.graph);
+		} catch (const std::bad_alloc &) {
+			result.error = "the solver ran out of memory";
+		}
+		std::string line = r.id;
+		if (result.error) {
+			line += " error ";
+			line += result.error;
+		} else {
+			line += " " + std::to_string(result.cut);
+			for (size_t v = 0; v < result.sides.size(); v++)
+				if (result.sides[v])
+					line += " " + std::to_string(v + 1);
+		}
+		line += "\n";
+		r.from->answer(line);
+		double done = get_time();
+		size_t left;
+		{
+			std::lock_guard<std::mutex> lock(queue_mutex);
+			left = queue.size();
+			served++;
+			total_latency += done - r.arrived;
+		}
+		fprintf(stderr, "request %s V %d E %zu cut %lld queued %d left %zu wait %.3lf solve %.3lf latency %.3lf\n",
+		        r.id.c_str(), r.graph.num_vertices, r.graph.edge_u.size(), (long long)result.cut, r.depth, left,
+		        started - r.arrived, done - started, done - r.arrived);
+	}
+}
+
+// every client gets a thread reading its requests, answers go back on the same socket
+void serve(const char *path) {
+	sockaddr_un addr;
+	std::memset(&addr, 0, sizeof(addr));
+	addr.sun_family = AF_UNIX;
+	if (strlen(path) >= sizeof(addr.sun_path)) exit(ENAMETOOLONG);
+	strcpy(addr.sun_path, path);
+	int server = socket(AF_UNIX, SOCK_STREAM, 0);
+	unlink(path);
+	if (server < 0 || bind(server, (sockaddr *)&addr, sizeof(addr)) || listen(server, SOMAXCONN)) exit(errno);
+	fprintf(stderr, "listening on %s with %d solver threads\n", path, num_threads);
+	while (true) {
+		int sock = accept(server, nullptr, nullptr);
+		if (sock < 0 && errno == EINTR) continue;
+		if (sock < 0) exit(errno);
+		FILE *in = fdopen(dup(sock), "r");
+		if (!in) exit(errno);
+		std::thread(read_requests, in, std::make_shared<client>(sock, true)).detach();
+	}
+}
+
+int main(int argc, char **argv) {
+	starts_at = get_time();
+
+	int opt;
+	while ((opt = getopt(argc, argv, "j:L:s:m:g:l:n:x:R:v")) != -1) {
+		switch (opt) {
+		case 'j':  // solver threads, each solving one request at a time
+			num_threads = atoi(optarg);
+			break;
+		case 'L':  // take clients on this socket instead of reading stdin
+			listen_path = optarg;
+			break;
+		case 's':  // random seed, request i is solved with seed + i
+			options.seed = strtoull(optarg, nullptr, 10);
+			break;
+		case 'm':  // memory for chromosomes per solve in MB, like ga -m
+			options.population_mb = atoi(optarg);
+			break;
+		case 'g':  // memory for cached gains per solve in MB, like ga -g
+			options.gain_cache_mb = atoi(optarg);
+			break;
+		case 'l':  // local search after the descent, greedy or tabu
+			if (strcmp(optarg, "greedy") && strcmp(optarg, "tabu")) {
+				fprintf(stderr, "unknown local search %s\n", optarg);
+				return 1;
+			}
+			options.tabu = !strcmp(optarg, "tabu");
+			break;
+		case 'n':  // moves of one tabu search
+			options.tabu_iterations = atoi(optarg);
+			break;
+		case 'x':  // end a solve after this many generations without improvement, before its time budget
+			options.stall_limit = atoi(optarg);
+			break;
+		case 'R':  // restart after this many generations without improvement, keeping the elite
+			options.restart_interval = atoi(optarg);
+			break;
+		case 'v':  // progress lines of every solve on stderr
+			options.verbose = true;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-j threads] [-L socket] [-s seed] [-m population MB] [-g gain cache MB]\n"
+			                "          [-l greedy|tabu] [-n tabu moves] [-x stall] [-R restart] [-v] [< requests > answers]\n",
+			        argv[0]);
+			return 1;
+		}
+	}
+	if (num_threads <= 0)
+		num_threads = std::max(1u, std::thread::hardware_concurrency());
+	signal(SIGPIPE, SIG_IGN);  // a client that went away fails its write instead
+	options.keep_memory = true;
+
+	std::vector<std::thread> solvers;
+	for (int i = 0; i < num_threads; i++)
+		solvers.emplace_back(solve_requests);
+	if (listen_path)
+		serve(listen_path);  // until the process is killed
+	read_requests(stdin, std::make_shared<client>(1, false));
+	{
+		std::lock_guard<std::mutex> lock(queue_mutex);
+		closing = true;
+	}
+	queue_wakeup.notify_all();
+	for (auto &t : solvers)
+		t.join();
+	fprintf(stderr, "served %lld requests in %lf s, mean latency %.3lf, max queue %d\n", served, get_time() - starts_at,
+	        served ? total_latency / served : 0.0, max_depth);
+}
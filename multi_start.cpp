@@ -3,71 +3,203 @@
 #include <ctime>
 #include <cerrno>
 #include <cstring>
+#include <cstdint>
+#include <cmath>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include <vector>
 #include <queue>
 #include <tuple>
 #include <algorithm>
+#include <thread>
+#include <atomic>
+#include <memory>
 
-#define MAX_V 5000
-#define MAX_E 40000
+#include "common.h"
 
-#define MAX_POPULATION 8175616
+#define NUM_THREADS 0  // 0: one thread per hardware thread, overridden by -j
+#define HISTOGRAM_BINS 50  // between total_weight / 2, below which no local optimum lies, and the positive weights
+#define HLL_BITS 12  // 4096 registers, about 1.6% error on the distinct optima
+#define TOP_K 0  // optima kept for -o, overridden by -k
 
-int V, E;
-int edges[MAX_E][3];
-std::vector<int> vertices[MAX_V];
-std::vector<std::pair<int, int>> infos[MAX_V];
-std::priority_queue<std::pair<int, int>> Q;
+// samples random local optima without keeping them: every thread builds a chromosome,
+// runs local_opt() and folds the result into its own running statistics, merged at the end.
+// memory is the graph plus O(V) per thread and the top-k, however many samples are taken
 
+double starts_at;
+
+int V;
+int64_t E;
+int64_t total_weight, positive_weight;
+std::vector<int> edge_u, edge_v, edge_w;
+std::vector<int64_t> offsets;  // neighbours of u are neighbors[offsets[u]] .. neighbors[offsets[u + 1] - 1]
+std::vector<int> neighbors, weights;  // adjacency in the renumbered order
+std::vector<uint8_t> visits;
+std::vector<int> renumbers, real_numbers;
 int renumber_cnt;
-uint8_t visits[MAX_V];
-int degrees[MAX_V], renumbers[MAX_V], real_numbers[MAX_V];
+std::priority_queue<std::pair<int, int>> Q;  // only for renumber()
+
+int num_threads = NUM_THREADS;
+long long max_samples = -1;  // -n, unlimited if only -t is given
+double time_limit = -1;  // -t, unlimited if only -n is given
+int top_k = TOP_K;
+const char *top_path;
 
-class chromosome {
+// xorshift64*, one per thread
+class random_generator {
 public:
-	uint8_t genes[MAX_V];
-	int score = INT32_MAX;
-
-	chromosome(bool initialize = false) {
-		if (initialize)
-			for (int i = 0; i < V; i += 31) {
-				int rand_num = rand();  // 31-bits
-				int end = std::max(i + 31, V);
-				for (int j = i; j < end; j++) {
-					genes[j] = rand_num % 2;
-					rand_num >>= 1;
-				}
-			}
+	uint64_t state;
+
+	random_generator(uint64_t seed = 0) {
+		state = seed * 0x9E3779B97F4A7C15ULL + 0x2545F4914F6CDD1DULL;
+		if (state == 0) state = 1;
+	}
+
+	uint32_t next() {
+		state ^= state >> 12;
+		state ^= state << 25;
+		state ^= state >> 27;
+		return (state * 0x2545F4914F6CDD1DULL) >> 32;
+	}
+};
+
+// a local optimum as bits by renumbered vertex, complement-normalized so gene 0 is unset
+class optimum {
+public:
+	int64_t score;
+	uint64_t hash;
+	std::vector<uint64_t> genes;
+
+	// min-heap of the top-k by score
+	bool operator<(const optimum &other) const {
+		return score > other.score || (score == other.score && hash < other.hash);
+	}
+};
+
+// everything a thread folds its samples into, merged with += at the end
+class statistics {
+public:
+	long long samples = 0;
+	int64_t best = INT64_MIN;
+	double sum = 0;
+	long long histogram[HISTOGRAM_BINS] = {};
+	uint8_t registers[1 << HLL_BITS] = {};  // HyperLogLog of the optima hashes
+	std::vector<optimum> top;  // heap, worst of the kept optima first
+
+	void add(int64_t score, uint64_t hash, const std::vector<uint64_t> &genes) {
+		samples++;
+		best = std::max(best, score);
+		sum += score;
+		histogram[bin(score)]++;
+		int rank = std::min(__builtin_clzll((hash << HLL_BITS) | 1) + 1, 64 - HLL_BITS + 1);
+		uint8_t &reg = registers[hash >> (64 - HLL_BITS)];
+		reg = std::max<uint8_t>(reg, rank);
+		// copy the genes only if they would be kept
+		if (top_k && ((int)top.size() < top_k || optimum{score, hash, {}} < top.front()))
+			keep(optimum{score, hash, genes});
+	}
+
+	// ignores optima already kept, evicts the worst if full
+	void keep(const optimum &opt) {
+		for (auto &kept : top)
+			if (kept.hash == opt.hash) return;
+		if ((int)top.size() < top_k) {
+			top.push_back(opt);
+			std::push_heap(top.begin(), top.end());
+		} else if (opt < top.front()) {
+			std::pop_heap(top.begin(), top.end());
+			top.back() = opt;
+			std::push_heap(top.begin(), top.end());
+		}
+	}
+
+	static int bin(int64_t score) {
+		double low = total_weight / 2.0, width = (positive_weight - low) / HISTOGRAM_BINS;
+		if (width <= 0) return 0;
+		int b = (score - low) / width;
+		return std::min(std::max(b, 0), HISTOGRAM_BINS - 1);
+	}
+
+	statistics &operator+=(const statistics &other) {
+		samples += other.samples;
+		best = std::max(best, other.best);
+		sum += other.sum;
+		for (int i = 0; i < HISTOGRAM_BINS; i++)
+			histogram[i] += other.histogram[i];
+		for (int i = 0; i < 1 << HLL_BITS; i++)
+			registers[i] = std::max(registers[i], other.registers[i]);
+		for (auto &opt : other.top)
+			keep(opt);
+		return *this;
 	}
 
-	chromosome(chromosome *other) {
-		std::memcpy(genes, other->genes, V * sizeof(uint8_t));
+	double distinct() const {
+		int m = 1 << HLL_BITS, zeros = 0;
+		double harmonic = 0;
+		for (int i = 0; i < m; i++) {
+			harmonic += std::ldexp(1.0, -registers[i]);
+			zeros += registers[i] == 0;
+		}
+		double estimate = 0.7213 / (1 + 1.079 / m) * m * m / harmonic;
+		if (estimate <= 2.5 * m && zeros)
+			estimate = m * std::log((double)m / zeros);  // linear counting for small counts
+		return estimate;
 	}
+};
 
-	chromosome *local_opt() {
-		std::memset(degrees, 0, V * sizeof(int));
-		score = 0;
-		for (int i = 0; i < E; i++) {
-			if (genes[edges[i][0]] != genes[edges[i][1]]) {
-				score += edges[i][2];
-				degrees[edges[i][0]] -= edges[i][2];
-				degrees[edges[i][1]] -= edges[i][2];
+// per-thread scratch, nothing is shared but the graph and the sample counter
+class sampler {
+public:
+	random_generator rng;
+	std::vector<uint8_t> genes;
+	std::vector<int> degrees;
+	std::vector<uint64_t> packed;
+	gain_heap heap;
+	statistics stats;
+
+	sampler(uint64_t seed) : rng(seed), genes(V), degrees(V), packed((V + 63) / 64) {
+		heap.init(V);
+	}
+
+	void sample() {
+		for (int i = 0; i < V; i++)
+			genes[i] = rng.next() & 1;
+		int64_t score = local_opt();
+		// the complement is the same cut, keep the one with vertex 0 unset
+		std::fill(packed.begin(), packed.end(), 0);
+		uint8_t flip = V ? genes[0] : 0;
+		for (int i = 0; i < V; i++)
+			if (genes[i] ^ flip)
+				packed[i >> 6] |= 1ULL << (i & 63);
+		uint64_t hash = 0;
+		for (uint64_t word : packed) {
+			hash = (hash ^ word) * 0x9E3779B97F4A7C15ULL;
+			hash ^= hash >> 29;
+		}
+		stats.add(score, hash, packed);
+	}
+
+	// flip the vertex of largest positive gain until there is none
+	int64_t local_opt() {
+		std::fill(degrees.begin(), degrees.end(), 0);
+		int64_t score = 0;
+		for (int64_t i = 0; i < E; i++) {
+			if (genes[edge_u[i]] != genes[edge_v[i]]) {
+				score += edge_w[i];
+				degrees[edge_u[i]] -= edge_w[i];
+				degrees[edge_v[i]] -= edge_w[i];
 			} else {
-				degrees[edges[i][0]] += edges[i][2];
-				degrees[edges[i][1]] += edges[i][2];
+				degrees[edge_u[i]] += edge_w[i];
+				degrees[edge_v[i]] += edge_w[i];
 			}
 		}
-		for (int i = 0; i < V; i++)
-			if (degrees[i] > 0)
-				Q.emplace(degrees[i], i);
-		while (!Q.empty()) {
-			auto [diff, u] = Q.top();
-			Q.pop();
-			if (diff != degrees[u])
-				continue;
-			score += diff;
-			for (auto [v, w] : infos[u]) {
+		heap.reset(degrees.data());
+		int u;
+		while ((u = heap.pop()) >= 0) {
+			score += degrees[u];
+			for (int64_t i = offsets[u]; i < offsets[u + 1]; i++) {
+				int v = neighbors[i], w = weights[i];
 				if (genes[u] != genes[v]) {
 					degrees[u] += 2 * w;
 					degrees[v] += 2 * w;
@@ -75,84 +207,107 @@ public:
 					degrees[u] -= 2 * w;
 					degrees[v] -= 2 * w;
 				}
-				if (degrees[v] > 0)
-					Q.emplace(degrees[v], v);
+				heap.update(v);
 			}
 			genes[u] = 1 - genes[u];
-			if (degrees[u] > 0)
-				Q.emplace(degrees[u], u);
-		}
-		return this;
-	}
-
-	int evaluate() {
-		if (score == INT32_MAX) {
-			score = 0;
-			for (int i = 0; i < E; i++)
-				if (genes[edges[i][0]] != genes[edges[i][1]])
-					score += edges[i][2];
 		}
 		return score;
 	}
 };
 
-class evaluation {
-public:
-	int score;
-	chromosome *chr;
-
-	evaluation() = default;
-	evaluation(chromosome *chr_) : chr(chr_) {
-		score = chr->evaluate();
-	}
-
-	bool operator<(const evaluation &other) {
-		return score > other.score;
-	}
-};
+std::atomic<long long> next_sample;
 
-class population {
-public:
-	chromosome *chrs[MAX_POPULATION];
-	evaluation evals[MAX_POPULATION];
-
-	population() {
-		for (int i = 0; i < MAX_POPULATION; i++) {
-			chrs[i] = new chromosome(true);
-			chrs[i]->local_opt();
-			evals[i] = evaluation(chrs[i]);
-		}
+void run(sampler *s) {
+	while (true) {
+		if (max_samples >= 0 && next_sample.fetch_add(1) >= max_samples) break;
+		if (time_limit >= 0 && get_time() - starts_at >= time_limit) break;
+		s->sample();
 	}
-} *group;
+}
 
 void get_input() {
 	// get input
 	int u, v, w;
-	if (scanf("%d %d", &V, &E) != 2) exit(errno);
-	for (int i = 0; i < E; i++) {
+	long long m;
+	if (scanf("%d %lld", &V, &m) != 2) exit(errno);
+	if (V < 0 || m < 0) exit(EINVAL);
+	E = m;
+	// an edge takes at least 6 characters, " u v w", so only a file the header fits in is reserved for,
+	// a pipe grows the edge list as the edges come
+	struct stat st;
+	if (fstat(fileno(stdin), &st) == 0 && S_ISREG(st.st_mode)) {
+		if (E > st.st_size / 6) exit(EINVAL);
+		edge_u.reserve(E);
+		edge_v.reserve(E);
+		edge_w.reserve(E);
+	}
+	for (int64_t i = 0; i < E; i++) {
 		if (scanf("%d %d %d", &u, &v, &w) != 3) exit(errno);
+		if (u < 1 || u > V || v < 1 || v > V) exit(EINVAL);
+		if (u == v) continue;  // a loop is never cut
 		// change from 1-base to 0-base
-		u--;
-		v--;
-		edges[i][0] = u;
-		edges[i][1] = v;
-		edges[i][2] = w;
-		vertices[u].push_back(v);
-		vertices[v].push_back(u);
+		edge_u.push_back(u - 1);
+		edge_v.push_back(v - 1);
+		edge_w.push_back(w);
+		total_weight += w;
+		positive_weight += std::max(w, 0);
 	}
+	E = edge_u.size();
 }
 
-void dfs(int u) {
-	if (visits[u]) return;
+// adjacency of the current edge list
+void build_adjacency() {
+	offsets.assign(V + 1, 0);
+	for (int64_t i = 0; i < E; i++) {
+		offsets[edge_u[i] + 1]++;
+		offsets[edge_v[i] + 1]++;
+	}
+	for (int i = 0; i < V; i++)
+		offsets[i + 1] += offsets[i];
+	neighbors.resize(2 * E);
+	weights.resize(2 * E);
+	std::vector<int64_t> next(offsets.begin(), offsets.end() - 1);
+	for (int64_t i = 0; i < E; i++) {
+		neighbors[next[edge_u[i]]] = edge_v[i];
+		weights[next[edge_u[i]]++] = edge_w[i];
+		neighbors[next[edge_v[i]]] = edge_u[i];
+		weights[next[edge_v[i]]++] = edge_w[i];
+	}
+}
+
+void visit(int u) {
 	visits[u] = 1;
 	renumbers[u] = renumber_cnt;
 	real_numbers[renumber_cnt] = u;
 	renumber_cnt++;
-	for (int v : vertices[u])
-		dfs(v);
+}
+
+// preorder like the recursive version, with an explicit stack
+void dfs(int root) {
+	if (visits[root]) return;
+	std::vector<std::pair<int, int64_t>> stack;
+	visit(root);
+	stack.emplace_back(root, offsets[root]);
+	while (!stack.empty()) {
+		int u = stack.back().first;
+		int64_t &next = stack.back().second;
+		if (next == offsets[u + 1]) {
+			stack.pop_back();
+			continue;
+		}
+		int v = neighbors[next++];
+		if (visits[v]) continue;
+		visit(v);
+		stack.emplace_back(v, offsets[v]);
+	}
 }
 
 void renumber() {
+	build_adjacency();
+	visits.assign(V, 0);
+	renumbers.resize(V);
+	real_numbers.resize(V);
+	std::vector<int> degrees(V);
 	Q.emplace(0, rand() % V);
 	while (!Q.empty()) {
 		int u = Q.top().second;
@@ -160,42 +315,137 @@ void renumber() {
 		if (visits[u]) continue;
 		visits[u] = 1;
 		renumbers[u] = renumber_cnt++;
-		for (int v : vertices[u]) {
+		for (int64_t i = offsets[u]; i < offsets[u + 1]; i++) {
+			int v = neighbors[i];
 			if (visits[v]) continue;
 			degrees[v]++;
 			Q.emplace(degrees[v], v);
 		}
 	}
-	for (int i = 0; i < V; i++)
-		std::sort(vertices[i].begin(), vertices[i].end(),
-			[&](int x, int y) {
-				return renumbers[x] < renumbers[y];
-			}
-		);
+	// neighbours in the order of the first numbering
+	for (int u = 0; u < V; u++) {
+		std::vector<std::pair<int, int64_t>> row;
+		for (int64_t i = offsets[u]; i < offsets[u + 1]; i++)
+			row.emplace_back(renumbers[neighbors[i]], i);
+		std::sort(row.begin(), row.end());
+		std::vector<int> sorted;
+		for (auto &entry : row)
+			sorted.push_back(neighbors[entry.second]);
+		std::copy(sorted.begin(), sorted.end(), neighbors.begin() + offsets[u]);
+	}
 	// concerns: some vertices cannot be visited
 	// but seeming there is no such vertex, all seem to be connected
-	std::memset(visits, 0, sizeof(visits));
+	std::fill(visits.begin(), visits.end(), 0);
 	renumber_cnt = 0;
 	for (int i = 0; i < V; i++)
 		dfs(i);
-	for (int i = 0; i < E; i++) {
-		edges[i][0] = renumbers[edges[i][0]];
-		edges[i][1] = renumbers[edges[i][1]];
-		infos[edges[i][0]].emplace_back(edges[i][1], edges[i][2]);
-		infos[edges[i][1]].emplace_back(edges[i][0], edges[i][2]);
+	for (int64_t i = 0; i < E; i++) {
+		edge_u[i] = renumbers[edge_u[i]];
+		edge_v[i] = renumbers[edge_v[i]];
+	}
+	build_adjacency();
+}
+
+// what the instance will cost at this V and E, printed before sampling
+void report_memory() {
+	size_t words = (V + 63) / 64;
+	double graph = (3 * E + 4 * E + 2 * (double)V) * sizeof(int) + (V + 1) * sizeof(int64_t) + V;  // edges, adjacency, maps, offsets, visits
+	double thread = V * (sizeof(uint8_t) + 3 * sizeof(int)) + words * sizeof(uint64_t) + sizeof(statistics)
+	                + top_k * (sizeof(optimum) + words * sizeof(uint64_t));  // sampler, its heap and its top-k
+	fprintf(stderr, "memory: V %d, E %lld, graph %.1lf MB, %d threads of %.1lf MB\n", V, (long long)E, graph / 1048576,
+	        num_threads, thread / 1048576);
+}
+
+// the kept optima best first, one partition per line like the output of ga,
+// ga -i reads them into its first population
+void write_top(const statistics &stats, const char *path) {
+	FILE *file = fopen(path, "w");
+	if (!file) exit(errno);
+	std::vector<optimum> top = stats.top;
+	std::sort(top.begin(), top.end());
+	for (auto &opt : top) {
+		std::vector<uint8_t> sides(V);
+		for (int i = 0; i < V; i++)
+			sides[real_numbers[i]] = opt.genes[i >> 6] >> (i & 63) & 1;
+		for (int i = 0; i < V; i++)
+			if (sides[i])
+				fprintf(file, "%d ", i + 1);
+		fprintf(file, "\n");
 	}
+	fclose(file);
 }
 
-int main() {
+int main(int argc, char **argv) {
+	// get start time
+	starts_at = get_time();
+
+	int opt;
+	unsigned seed = time(NULL);
+	while ((opt = getopt(argc, argv, "j:n:t:s:k:o:")) != -1) {
+		switch (opt) {
+		case 'j':  // number of sampling threads
+			num_threads = atoi(optarg);
+			break;
+		case 'n':  // number of local optima to sample
+			max_samples = atoll(optarg);
+			break;
+		case 't':  // seconds to sample, whichever of -n and -t comes first
+			time_limit = atof(optarg);
+			break;
+		case 's':  // random seed
+			seed = strtoul(optarg, nullptr, 10);
+			break;
+		case 'k':  // best distinct optima to keep for -o
+			top_k = atoi(optarg);
+			break;
+		case 'o':  // write the kept optima here
+			top_path = optarg;
+			break;
+		default:
+			fprintf(stderr, "usage: %s [-j threads] [-n samples] [-t seconds] [-s seed] [-k top] [-o file] < input\n",
+			        argv[0]);
+			return 1;
+		}
+	}
+	if (max_samples < 0 && time_limit < 0)
+		max_samples = 1000;
+	if (top_path && top_k == 0)
+		top_k = 16;
+
 	// srand, rand is fast, we do not need true-randomness
-	srand(time(NULL));
+	srand(seed);
 
 	get_input();
+	if (V == 0) return 0;
 	renumber();
-	group = new population();
-	int score = 0;
-	for (int i = 0; i < MAX_POPULATION; i++)
-		score = std::max(score, group->evals[i].score);
-	fprintf(stderr, "%d\n", score);
+
+	if (num_threads <= 0)
+		num_threads = std::max(1u, std::thread::hardware_concurrency());
+	report_memory();
+	std::vector<std::unique_ptr<sampler>> samplers;
+	for (int i = 0; i < num_threads; i++)
+		samplers.emplace_back(new sampler(rand()));
+	double sampling_at = get_time();
+	std::vector<std::thread> threads;
+	for (int i = 1; i < num_threads; i++)
+		threads.emplace_back(run, samplers[i].get());
+	run(samplers[0].get());
+	for (auto &t : threads)
+		t.join();
+	double seconds = get_time() - sampling_at;
+
+	statistics *stats = &samplers[0]->stats;
+	for (int i = 1; i < num_threads; i++)
+		*stats += samplers[i]->stats;
+	if (stats->samples == 0) return 0;
+	fprintf(stderr, "samples %lld in %lf s, %.1lf per second\n", stats->samples, seconds, stats->samples / seconds);
+	fprintf(stderr, "mean %.2lf, distinct about %.0lf\n", stats->sum / stats->samples, stats->distinct());
+	double low = total_weight / 2.0, width = (positive_weight - low) / HISTOGRAM_BINS;
+	for (int i = 0; i < HISTOGRAM_BINS; i++)
+		if (stats->histogram[i])
+			fprintf(stderr, "hist %.1lf %.1lf %lld\n", low + i * width, low + (i + 1) * width, stats->histogram[i]);
+	if (top_path)
+		write_top(*stats, top_path);
+	fprintf(stderr, "%lld\n", (long long)stats->best);
 	return 0;
-}
\ No newline at end of file
+}